@@ -3,10 +3,12 @@
 #include "bithacks.h"
 #include "types.h"
 #include "value.h"
+#include "zobrist_hash.h"
 
 #include <cassert>
 #include <cstdlib>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace engine
@@ -562,19 +564,76 @@ using EndgameBasePtr = std::unique_ptr<EndgameBase>;
 
 std::vector<EndgameBasePtr> endgames;
 
+/**
+ * Specialized endgames by material key (Position::material_hash()),
+ * so that positions without one cost a single failed lookup.
+ */
+std::unordered_map<uint64_t, const EndgameBase*> endgames_by_material;
+
+/**
+ * kKXK applies to any material against a lone king,
+ * so it is checked separately after the lookup.
+ */
+const EndgameBase* kxk_endgames[COLOR_NUM];
+
+template <EndgameType endgameType>
+const EndgameBase* make_endgame(Color strongSide)
+{
+    endgames.push_back(EndgameBasePtr(new Endgame<endgameType>(strongSide)));
+    return endgames.back().get();
+}
+
+/**
+ * @brief Registers endgame under given material signatures (with white
+ * as the strong side) and their mirrored versions.
+ * When signatures of two endgames overlap the one added first is used.
+ */
+template <EndgameType endgameType>
+void add(const std::vector<PieceCountVector>& pcvs)
+{
+    const EndgameBase* white = make_endgame<endgameType>(WHITE);
+    const EndgameBase* black = make_endgame<endgameType>(BLACK);
+    for (PieceCountVector pcv : pcvs)
+    {
+        endgames_by_material.emplace(zobrist::material_key(pcv), white);
+        endgames_by_material.emplace(zobrist::material_key(flip_pcv(pcv)), black);
+    }
+}
+
+/**
+ * @brief Registers endgame with single material signature.
+ */
 template <EndgameType endgameType>
 void add()
 {
-    endgames.push_back(
-        std::unique_ptr<EndgameBase>(new Endgame<endgameType>(WHITE)));
-    endgames.push_back(
-        std::unique_ptr<EndgameBase>(new Endgame<endgameType>(BLACK)));
+    static_assert(flip_pcv(SandboxPCV<endgameType>::pcv[WHITE]) ==
+                  SandboxPCV<endgameType>::pcv[BLACK]);
+    add<endgameType>({SandboxPCV<endgameType>::pcv[WHITE]});
 }
 
 void init()
 {
+    endgames.clear();
+    endgames_by_material.clear();
+
+    std::vector<PieceCountVector> kpsk, kbpsk, kbpskb, kqkrps;
+    for (int pawns = 1; pawns <= 8; ++pawns)
+    {
+        if (pawns >= 2) kpsk.push_back(create_pcv(pawns, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+        kbpsk.push_back(create_pcv(pawns, 0, 1, 0, 0, 0, 0, 0, 0, 0));
+        kbpskb.push_back(create_pcv(pawns, 0, 1, 0, 0, 0, 0, 1, 0, 0));
+        kqkrps.push_back(create_pcv(0, 0, 0, 0, 1, pawns, 0, 0, 1, 0));
+    }
+
+    std::vector<PieceCountVector> kmmkm;
+    for (int knights = 0; knights <= 2; ++knights)
+    {
+        kmmkm.push_back(create_pcv(0, knights, 2 - knights, 0, 0, 0, 1, 0, 0, 0));
+        kmmkm.push_back(create_pcv(0, knights, 2 - knights, 0, 0, 0, 0, 1, 0, 0));
+    }
+
     add<kKPK>();
-    add<kKPsK>();
+    add<kKPsK>(kpsk);
     add<kKRKB>();
     add<kKRKN>();
     add<kKNNK>();
@@ -583,25 +642,38 @@ void init()
     add<kKNBK>();
     add<kKRNKR>();
     add<kKRBKR>();
-    add<kKBPsK>();
-    add<kKBPsKB>();
+    add<kKBPsK>(kbpsk);
+    add<kKBPsKB>(kbpskb);
     add<kKRKP>();
     add<kKQKP>();
-    add<kKQKRPs>();
-    add<kKmmKm>();
+    add<kKQKRPs>(kqkrps);
+    add<kKmmKm>(kmmkm);
 
-    // kKXK must be last
-    add<kKXK>();
+    kxk_endgames[WHITE] = make_endgame<kKXK>(WHITE);
+    kxk_endgames[BLACK] = make_endgame<kKXK>(BLACK);
 }
 
-Value score(const Position& position)
+const EndgameBase* find(const Position& position)
 {
-    for (const EndgameBasePtr& e : endgames)
+    const auto it = endgames_by_material.find(position.material_hash());
+    if (it != endgames_by_material.end())
+    {
+        assert(it->second->applies(position));
+        return it->second;
+    }
+
+    for (const EndgameBase* e : kxk_endgames)
     {
-        if (e->applies(position)) return e->score(position);
+        if (e->applies(position)) return e;
     }
 
-    return VALUE_NONE;
+    return nullptr;
+}
+
+Value score(const Position& position)
+{
+    const EndgameBase* endgame = find(position);
+    return endgame ? endgame->score(position) : VALUE_NONE;
 }
 
 }  // namespace endgame
@@ -7,12 +7,36 @@
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace engine
 {
 namespace bitbase
 {
-void init();
+constexpr uint32_t MAX_INDEX = 2 * 24 * 64 * 64;
+
+// index:
+// 0-5   : white king
+// 6-11  : black king
+// 12    : color
+// 13-14 : pawn file
+// 15-17 : pawn rank
+constexpr uint32_t get_index(Color side, Square wKing, Square wPawn, Square bKing)
+{
+    assert(file(wPawn) <= FILE_D);
+    assert(RANK_2 <= rank(wPawn) && rank(wPawn) <= RANK_7);
+    uint32_t index = wKing | (bKing << 6) | (side << 12) | (file(wPawn) << 13) |
+                     ((rank(wPawn) - RANK_2) << 15);
+    assert(index < MAX_INDEX);
+    return index;
+}
+
+/**
+ * @brief Solves KPK by retrograde analysis, returns bitset of positions
+ * won by white. Run at build time by bitbase_generator, the result
+ * is compiled into the engine.
+ */
+std::vector<uint32_t> generate();
 
 bool check(Color side, Square wKing, Square wPawn, Square bKing);
 
@@ -61,8 +85,19 @@ class EndgameBase
     Piece strongKing, weakKing;
 };
 
+/**
+ * @brief Registers all specialized endgames,
+ * has to be called after zobrist::init().
+ */
 void init();
 
+/**
+ * @brief Returns specialized endgame applicable to position (nullptr
+ * if there is none). It depends only on material of the position,
+ * so it can be cached by material key.
+ */
+const EndgameBase* find(const Position& position);
+
 Value score(const Position& position);
 
 }  // namespace endgame
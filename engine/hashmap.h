@@ -32,6 +32,11 @@ namespace engine
                 return entry;
             }
 
+            void prefetch(const Key& key) const
+            {
+                __builtin_prefetch(&data_[key & (Size - 1)]);
+            }
+
             void insert(const Key& key, const Value& value)
             {
                 data_[key & (Size - 1)] = Entry{key, epoch_, value};
@@ -39,6 +39,9 @@ struct Info
 
 using StackInfo = std::array<Info, MAX_DEPTH * 2>;
 
+// move buffers for each ply, owned by a single search thread
+using MoveStack = Array2D<Move, MAX_DEPTH * 2, MAX_MOVES>;
+
 } /* namespace engine */
 
 
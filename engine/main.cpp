@@ -1,5 +1,6 @@
 #include "endgame.h"
 #include "movegen.h"
+#include "psqt.h"
 #include "uci.h"
 #include "zobrist_hash.h"
 
@@ -8,8 +9,8 @@ using namespace engine;
 int main()
 {
     move_bitboards::init();
+    psqt::init();
     zobrist::init();
-    bitbase::init();
     endgame::init();
 
     Uci uci;
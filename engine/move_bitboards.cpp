@@ -3,6 +3,8 @@
 #include "bithacks.h"
 #include "types.h"
 
+#include <algorithm>
+
 namespace engine
 {
 Bitboard RAYS[RAYS_NUM][SQUARE_NUM];
@@ -84,8 +86,16 @@ int ROOK_INDEX_BITS[SQUARE_NUM] = {
 };
 // clang-format on
 
+#if defined(USE_PEXT)
+uint32_t BISHOP_OFFSETS[SQUARE_NUM];
+uint32_t ROOK_OFFSETS[SQUARE_NUM];
+
+Bitboard BISHOP_TABLE[0x1480];
+Bitboard ROOK_TABLE[0x19000];
+#else
 Bitboard BISHOP_TABLE[SQUARE_NUM][4096];
 Bitboard ROOK_TABLE[SQUARE_NUM][4096];
+#endif
 
 Bitboard CASTLING_PATHS[1 << 4];
 Bitboard LINES[SQUARE_NUM][SQUARE_NUM];
@@ -95,18 +105,6 @@ Bitboard QUEEN_CASTLING_BLOCK[COLOR_NUM] = {square_bb(SQ_B1), square_bb(SQ_B8)};
 
 namespace
 {
-Bitboard get_blockers_from_index(int index, Bitboard mask)
-{
-    Bitboard blockers = 0ULL;
-    int num_bits = popcount(mask);
-    for (int i = 0; i < num_bits; ++i)
-    {
-        Square position = Square(pop_lsb(&mask));
-        if (index & (1 << i)) blockers |= square_bb(position);
-    }
-    return blockers;
-}
-
 Bitboard get_attack_in_ray(Square sq, Ray ray, Bitboard blockers)
 {
     Bitboard masked_blockers = blockers & RAYS[ray][sq];
@@ -224,41 +222,63 @@ void init_king_mask()
 
 void init_bishop_magics()
 {
+#ifndef NDEBUG
+    std::fill_n(reinterpret_cast<Bitboard*>(BISHOP_TABLE),
+                sizeof(BISHOP_TABLE) / sizeof(Bitboard), all_squares_bb);
+#endif
+#if defined(USE_PEXT)
+    uint32_t offset = 0;
     for (Square sq = SQ_A1; sq <= SQ_H8; ++sq)
     {
-        for (int i = 0; i < 4096; ++i) BISHOP_TABLE[sq][i] = all_squares_bb;
-        int num_blockers = 1 << BISHOP_INDEX_BITS[sq];
-        for (int index = 0; index < num_blockers; ++index)
+        BISHOP_OFFSETS[sq] = offset;
+        offset += 1 << popcount(BISHOP_MASK[sq]);
+    }
+    assert(offset == sizeof(BISHOP_TABLE) / sizeof(Bitboard));
+#endif
+
+    for (Square sq = SQ_A1; sq <= SQ_H8; ++sq)
+    {
+        // enumerate all subsets of the mask (Carry-Rippler trick)
+        Bitboard blockers = 0ULL;
+        do
         {
-            Bitboard blockers = get_blockers_from_index(index, BISHOP_MASK[sq]);
-            uint64_t key =
-                (blockers * BISHOP_MAGICS[sq]) >> (64 - BISHOP_INDEX_BITS[sq]);
+            Bitboard& entry = slider_table_entry<BISHOP>(sq, blockers);
             Bitboard moves = get_bishop_attacks(sq, blockers);
-            if (BISHOP_TABLE[sq][key] != all_squares_bb)
-                assert(BISHOP_TABLE[sq][key] == moves);
-            else
-                BISHOP_TABLE[sq][key] = moves;
-        }
+            assert(entry == all_squares_bb || entry == moves);
+            entry = moves;
+            blockers = (blockers - BISHOP_MASK[sq]) & BISHOP_MASK[sq];
+        } while (blockers);
     }
 }
 
 void init_rook_magics()
 {
+#ifndef NDEBUG
+    std::fill_n(reinterpret_cast<Bitboard*>(ROOK_TABLE),
+                sizeof(ROOK_TABLE) / sizeof(Bitboard), all_squares_bb);
+#endif
+#if defined(USE_PEXT)
+    uint32_t offset = 0;
+    for (Square sq = SQ_A1; sq <= SQ_H8; ++sq)
+    {
+        ROOK_OFFSETS[sq] = offset;
+        offset += 1 << popcount(ROOK_MASK[sq]);
+    }
+    assert(offset == sizeof(ROOK_TABLE) / sizeof(Bitboard));
+#endif
+
     for (Square sq = SQ_A1; sq <= SQ_H8; ++sq)
     {
-        for (int i = 0; i < 4096; ++i) ROOK_TABLE[sq][i] = all_squares_bb;
-        int num_blockers = 1 << ROOK_INDEX_BITS[sq];
-        for (int index = 0; index < num_blockers; ++index)
+        // enumerate all subsets of the mask (Carry-Rippler trick)
+        Bitboard blockers = 0ULL;
+        do
         {
-            Bitboard blockers = get_blockers_from_index(index, ROOK_MASK[sq]);
-            uint64_t key =
-                (blockers * ROOK_MAGICS[sq]) >> (64 - ROOK_INDEX_BITS[sq]);
+            Bitboard& entry = slider_table_entry<ROOK>(sq, blockers);
             Bitboard moves = get_rook_attacks(sq, blockers);
-            if (ROOK_TABLE[sq][key] != all_squares_bb)
-                assert(ROOK_TABLE[sq][key] == moves);
-            else
-                ROOK_TABLE[sq][key] = moves;
-        }
+            assert(entry == all_squares_bb || entry == moves);
+            entry = moves;
+            blockers = (blockers - ROOK_MASK[sq]) & ROOK_MASK[sq];
+        } while (blockers);
     }
 }
 
@@ -6,6 +6,10 @@
 
 #include <cassert>
 
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
+
 namespace engine
 {
 enum Ray : uint32_t
@@ -85,8 +89,23 @@ extern uint64_t BISHOP_MAGICS[SQUARE_NUM];
 extern int ROOK_INDEX_BITS[SQUARE_NUM];
 extern int BISHOP_INDEX_BITS[SQUARE_NUM];
 
+#if defined(USE_PEXT)
+// Slider attacks are indexed by pext of blockers with the mask,
+//  so tables can be packed densely: each square takes
+//  2^popcount(mask) entries starting at its offset.
+constexpr const char* SLIDER_ATTACKS_BACKEND = "pext";
+
+extern uint32_t ROOK_OFFSETS[SQUARE_NUM];
+extern uint32_t BISHOP_OFFSETS[SQUARE_NUM];
+
+extern Bitboard ROOK_TABLE[0x19000];
+extern Bitboard BISHOP_TABLE[0x1480];
+#else
+constexpr const char* SLIDER_ATTACKS_BACKEND = "magics";
+
 extern Bitboard ROOK_TABLE[SQUARE_NUM][4096];
 extern Bitboard BISHOP_TABLE[SQUARE_NUM][4096];
+#endif
 
 namespace move_bitboards
 {
@@ -102,21 +121,38 @@ inline Bitboard slider_attack(Square /* sq */, Bitboard /* blockers */)
     return 0ULL;
 }
 
+/*
+ * Returns entry of attack table for given slider piece
+ *  (bishop or rook) and blockers.
+ */
+template <PieceKind piece>
+inline Bitboard& slider_table_entry(Square sq, Bitboard blockers)
+{
+    static_assert(piece == BISHOP || piece == ROOK);
+    constexpr bool bishop = piece == BISHOP;
+    const Bitboard mask = bishop ? BISHOP_MASK[sq] : ROOK_MASK[sq];
+#if defined(USE_PEXT)
+    const uint64_t index = _pext_u64(blockers, mask);
+    return bishop ? BISHOP_TABLE[BISHOP_OFFSETS[sq] + index]
+                  : ROOK_TABLE[ROOK_OFFSETS[sq] + index];
+#else
+    const uint64_t magic = bishop ? BISHOP_MAGICS[sq] : ROOK_MAGICS[sq];
+    const int bits = bishop ? BISHOP_INDEX_BITS[sq] : ROOK_INDEX_BITS[sq];
+    const uint64_t key = ((blockers & mask) * magic) >> (64 - bits);
+    return bishop ? BISHOP_TABLE[sq][key] : ROOK_TABLE[sq][key];
+#endif
+}
+
 template <>
 inline Bitboard slider_attack<BISHOP>(Square sq, Bitboard blockers)
 {
-    blockers &= BISHOP_MASK[sq];
-    uint64_t key =
-        (blockers * BISHOP_MAGICS[sq]) >> (64 - BISHOP_INDEX_BITS[sq]);
-    return BISHOP_TABLE[sq][key];
+    return slider_table_entry<BISHOP>(sq, blockers);
 }
 
 template <>
 inline Bitboard slider_attack<ROOK>(Square sq, Bitboard blockers)
 {
-    blockers &= ROOK_MASK[sq];
-    uint64_t key = (blockers * ROOK_MAGICS[sq]) >> (64 - ROOK_INDEX_BITS[sq]);
-    return ROOK_TABLE[sq][key];
+    return slider_table_entry<ROOK>(sq, blockers);
 }
 
 template <>
@@ -0,0 +1,313 @@
+#include "move_picker.h"
+
+#include "movegen.h"
+#include "types.h"
+
+#include <algorithm>
+
+namespace engine
+{
+
+constexpr MoveScore TT_SCORE = 2'000'000;
+constexpr MoveScore CAPTURE_SCORE = TT_SCORE - 50;
+constexpr MoveScore PROMOTION_SCORE = CAPTURE_SCORE - 10;
+constexpr MoveScore KILLER_1_SCORE = PROMOTION_SCORE - 1;
+constexpr MoveScore KILLER_2_SCORE = KILLER_1_SCORE - 1;
+constexpr MoveScore MAX_QUIET_SCORE = KILLER_2_SCORE - 1;
+
+static_assert(CAPTURE_SCORE < TT_SCORE);
+static_assert(PROMOTION_SCORE < CAPTURE_SCORE);
+static_assert(KILLER_1_SCORE < PROMOTION_SCORE);
+static_assert(KILLER_2_SCORE < KILLER_1_SCORE);
+static_assert(MAX_QUIET_SCORE < KILLER_2_SCORE);
+
+/**
+ * @brief Bonus to order captures correctly.
+ * First consider captures where we gain material.
+ * Second consider captures of equal value.
+ * Third consider captures where we lose material.
+ * Inside each case we order by MVV-LVA
+ * First dim is PieceKind of captured piece,
+ * second dim is PieceKind of capturing piece.
+ */
+const int CAPTURE_BONUS[PIECE_KIND_NUM][PIECE_KIND_NUM] = {
+    {},
+    //   p,  n,  b,  r,  q,  k
+    {0, 14,  4,  3,  2,  1,  0},  // captured pawn
+    {0, 21, 16, 15,  7,  6,  5},  // captured knight
+    {0, 22, 18, 17, 10,  9,  8},  // captured bishop
+    {0, 25, 24, 23, 19, 12, 11},  // captured rook
+    {0, 29, 28, 27, 26, 20, 13},  // captured queen
+    {}};
+
+/**
+ * @brief Orders PieceKind by most value.
+ */
+constexpr int mostValue(PieceKind pieceKind)
+{
+    return static_cast<int>(pieceKind);
+}
+
+static_assert(mostValue(KING) == mostValue(QUEEN) + 1);
+static_assert(mostValue(QUEEN) == mostValue(ROOK) + 1);
+static_assert(mostValue(ROOK) == mostValue(BISHOP) + 1);
+static_assert(mostValue(BISHOP) == mostValue(KNIGHT) + 1);
+static_assert(mostValue(KNIGHT) == mostValue(PAWN) + 1);
+
+/**
+ * @brief Orders PieceKind by least value.
+ */
+constexpr int leastValue(PieceKind pieceKind)
+{
+    return mostValue(KING) - mostValue(pieceKind) + 1;
+}
+
+static_assert(leastValue(PAWN) == leastValue(KNIGHT) + 1);
+static_assert(leastValue(KNIGHT) == leastValue(BISHOP) + 1);
+static_assert(leastValue(BISHOP) == leastValue(ROOK) + 1);
+static_assert(leastValue(ROOK) == leastValue(QUEEN) + 1);
+static_assert(leastValue(QUEEN) == leastValue(KING) + 1);
+
+MovePicker::MovePicker(const Position& position, Move tt_move,
+                       const Info* info, const HistoryScore& history_score,
+                       Move counter_move, Move* buffer)
+    : _position(position),
+      _info(info),
+      _history_score(history_score),
+      _stage(TT_MOVE),
+      _tt_move(tt_move),
+      _killers{info->_killer_moves[0], info->_killer_moves[1]},
+      _counter_move(counter_move),
+      _moves(buffer),
+      _current(buffer),
+      _end(buffer),
+      _bad_end(buffer)
+{
+    if (_tt_move != NO_MOVE && !is_move_legal(_position, _tt_move))
+        _tt_move = NO_MOVE;
+}
+
+MovePicker::MovePicker(const Position& position, Move tt_move,
+                       const Info* info, const HistoryScore& history_score,
+                       Move* buffer, bool in_check)
+    : _position(position),
+      _info(info),
+      _history_score(history_score),
+      _stage(in_check ? EVASIONS_INIT : QS_TT_MOVE),
+      _tt_move(tt_move),
+      _killers{info->_killer_moves[0], info->_killer_moves[1]},
+      _counter_move(NO_MOVE),
+      _moves(buffer),
+      _current(buffer),
+      _end(buffer),
+      _bad_end(buffer)
+{
+    if (_tt_move != NO_MOVE &&
+        !(is_move_legal(_position, _tt_move) &&
+          (in_check || !_position.move_is_quiet(_tt_move))))
+        _tt_move = NO_MOVE;
+}
+
+MovePicker::MovePicker(const Position& position, Move tt_move,
+                       const Info* info, const HistoryScore& history_score,
+                       Move* begin, Move* end)
+    : _position(position),
+      _info(info),
+      _history_score(history_score),
+      _stage(LIST_INIT),
+      _tt_move(tt_move),
+      _killers{info->_killer_moves[0], info->_killer_moves[1]},
+      _counter_move(NO_MOVE),
+      _moves(begin),
+      _current(begin),
+      _end(end),
+      _bad_end(begin)
+{
+}
+
+Move MovePicker::next_move()
+{
+    switch (_stage)
+    {
+    case TT_MOVE:
+        _stage = CAPTURES_INIT;
+        if (_tt_move != NO_MOVE) return _tt_move;
+        [[fallthrough]];
+
+    case CAPTURES_INIT:
+        generate_captures();
+        _stage = CAPTURES_PICK;
+        [[fallthrough]];
+
+    case CAPTURES_PICK:
+        while (_current != _end)
+        {
+            Move move = pick_best();
+            if (move == _tt_move) continue;
+            if (is_good_capture(move)) return move;
+            *_bad_end++ = move;
+        }
+        _stage = KILLER_1;
+        [[fallthrough]];
+
+    case KILLER_1:
+        _stage = KILLER_2;
+        if (is_refutation(_killers[0])) return _killers[0];
+        [[fallthrough]];
+
+    case KILLER_2:
+        _stage = COUNTER_MOVE;
+        if (_killers[1] != _killers[0] && is_refutation(_killers[1]))
+            return _killers[1];
+        [[fallthrough]];
+
+    case COUNTER_MOVE:
+        _stage = QUIETS_INIT;
+        if (_counter_move != _killers[0] && _counter_move != _killers[1] &&
+            is_refutation(_counter_move))
+            return _counter_move;
+        [[fallthrough]];
+
+    case QUIETS_INIT:
+        _current = _end;
+        _end = generate_moves<QUIETS>(_position, _position.color(), _current);
+        for (Move* it = _current; it != _end; ++it)
+            _scores[it - _moves] = quiet_score(*it);
+        _stage = QUIETS_PICK;
+        [[fallthrough]];
+
+    case QUIETS_PICK:
+        while (_current != _end)
+        {
+            Move move = pick_best();
+            if (move != _tt_move && move != _killers[0] &&
+                move != _killers[1] && move != _counter_move)
+                return move;
+        }
+        _current = _moves;
+        _stage = BAD_CAPTURES;
+        [[fallthrough]];
+
+    case BAD_CAPTURES:
+        if (_current != _bad_end) return *_current++;
+        _stage = END;
+        return NO_MOVE;
+
+    case QS_TT_MOVE:
+        _stage = QS_CAPTURES_INIT;
+        if (_tt_move != NO_MOVE) return _tt_move;
+        [[fallthrough]];
+
+    case QS_CAPTURES_INIT:
+        generate_captures();
+        _stage = QS_CAPTURES_PICK;
+        [[fallthrough]];
+
+    case QS_CAPTURES_PICK:
+        // captures losing material are pruned
+        while (_current != _end)
+        {
+            Move move = pick_best();
+            if (move != _tt_move && is_good_capture(move)) return move;
+        }
+        _stage = END;
+        return NO_MOVE;
+
+    case EVASIONS_INIT:
+        _end = generate_moves<ALL_MOVES>(_position, _position.color(), _moves);
+        [[fallthrough]];
+
+    case LIST_INIT:
+        for (Move* it = _current; it != _end; ++it)
+            _scores[it - _moves] = move_score(*it);
+        _stage = LIST_PICK;
+        [[fallthrough]];
+
+    case LIST_PICK:
+        if (_current != _end) return pick_best();
+        _stage = END;
+        return NO_MOVE;
+
+    case END:
+        return NO_MOVE;
+    }
+
+    return NO_MOVE;
+}
+
+void MovePicker::generate_captures()
+{
+    _current = _moves;
+    _end = generate_moves<CAPTURES>(_position, _position.color(), _moves);
+    for (Move* it = _current; it != _end; ++it)
+        _scores[it - _moves] = capture_score(*it);
+}
+
+MoveScore MovePicker::capture_score(Move move) const
+{
+    const PieceKind moved_piece = make_piece_kind(_position.piece_at(from(move)));
+    const PieceKind promotion_piece = promotion(move);
+
+    if (promotion_piece != NO_PIECE_KIND)
+        return PROMOTION_SCORE + mostValue(promotion_piece);
+
+    // consider last move (re)captures first
+    if (to(move) == to((_info - 1)->_current_move))
+        return CAPTURE_SCORE + 40 + leastValue(moved_piece);
+
+    PieceKind captured_piece = make_piece_kind(_position.piece_at(to(move)));
+    // en passant
+    if (captured_piece == NO_PIECE_KIND) captured_piece = PAWN;
+    return CAPTURE_SCORE + CAPTURE_BONUS[captured_piece][moved_piece];
+}
+
+MoveScore MovePicker::quiet_score(Move move) const
+{
+    const Piece moved_piece = castling(move) == NO_CASTLING
+                                  ? _position.piece_at(from(move))
+                                  : NO_PIECE;
+    const int h = _history_score[_position.color()][from(move)][to(move)];
+    const int c = (*(_info - 1)->_counter_move)[moved_piece][to(move)];
+    return std::min(h + c, MAX_QUIET_SCORE);
+}
+
+MoveScore MovePicker::move_score(Move move) const
+{
+    if (move == _tt_move) return TT_SCORE;
+    if (!_position.move_is_quiet(move)) return capture_score(move);
+    if (move == _killers[0]) return KILLER_1_SCORE;
+    if (move == _killers[1]) return KILLER_2_SCORE;
+    return quiet_score(move);
+}
+
+bool MovePicker::is_good_capture(Move move) const
+{
+    // capturing piece of at least the same value never loses material
+    if (promotion(move) == NO_PIECE_KIND &&
+        PIECE_VALUE[make_piece_kind(_position.piece_at(to(move)))].mg >=
+            PIECE_VALUE[make_piece_kind(_position.piece_at(from(move)))].mg)
+        return true;
+
+    return _position.see(move) >= 0;
+}
+
+bool MovePicker::is_refutation(Move move) const
+{
+    return move != NO_MOVE && move != _tt_move &&
+           is_move_legal(_position, move) && _position.move_is_quiet(move);
+}
+
+Move MovePicker::pick_best()
+{
+    Move* best = _current;
+    for (Move* it = _current + 1; it != _end; ++it)
+    {
+        if (_scores[it - _moves] > _scores[best - _moves]) best = it;
+    }
+
+    std::swap(*best, *_current);
+    std::swap(_scores[best - _moves], _scores[_current - _moves]);
+    return *_current++;
+}
+
+}  // namespace engine
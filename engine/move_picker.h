@@ -0,0 +1,114 @@
+#ifndef CHESS_ENGINE_MOVE_PICKER_H_
+#define CHESS_ENGINE_MOVE_PICKER_H_
+
+#include "info.h"
+#include "position.h"
+#include "types.h"
+
+namespace engine
+{
+
+using MoveScore = int;
+
+/**
+ * @brief Returns moves one by one, best looking moves first.
+ *
+ * In the main search moves are generated in stages: TT move,
+ * good captures, killers, counter move, quiets and bad captures
+ * (losing material according to SEE). Each stage is generated
+ * and scored only when it is reached, so nodes which cut off early
+ * don't pay for generating and sorting all their moves.
+ * Quiescence search gets only captures which don't lose material
+ * (ordered by MVV-LVA), unless it is in check.
+ */
+class MovePicker
+{
+  public:
+    /**
+     * @brief Creates staged picker, generated moves are stored in buffer
+     * (which has to hold MAX_MOVES moves).
+     */
+    MovePicker(const Position& position, Move tt_move, const Info* info,
+               const HistoryScore& history_score, Move counter_move,
+               Move* buffer);
+
+    /**
+     * @brief Creates picker for quiescence search.
+     * It returns only captures and promotions, or all evasions when in check.
+     */
+    MovePicker(const Position& position, Move tt_move, const Info* info,
+               const HistoryScore& history_score, Move* buffer, bool in_check);
+
+    /**
+     * @brief Creates picker for already generated moves (e.g. root moves).
+     * All moves are scored at once and reordered in place as they are picked.
+     */
+    MovePicker(const Position& position, Move tt_move, const Info* info,
+               const HistoryScore& history_score, Move* begin, Move* end);
+
+    /**
+     * @brief Returns next move or NO_MOVE if there are no more moves.
+     */
+    Move next_move();
+
+  private:
+    enum Stage
+    {
+        TT_MOVE,
+        CAPTURES_INIT,
+        CAPTURES_PICK,
+        KILLER_1,
+        KILLER_2,
+        COUNTER_MOVE,
+        QUIETS_INIT,
+        QUIETS_PICK,
+        BAD_CAPTURES,
+        QS_TT_MOVE,
+        QS_CAPTURES_INIT,
+        QS_CAPTURES_PICK,
+        EVASIONS_INIT,
+        LIST_INIT,
+        LIST_PICK,
+        END
+    };
+
+    void generate_captures();
+
+    MoveScore capture_score(Move move) const;
+    MoveScore quiet_score(Move move) const;
+    MoveScore move_score(Move move) const;
+
+    bool is_good_capture(Move move) const;
+
+    /**
+     * @brief Checks if move (killer or counter move) can be returned
+     * in its own stage.
+     */
+    bool is_refutation(Move move) const;
+
+    /**
+     * @brief Returns move with highest score from [_current, _end)
+     * and moves it to the front of the range.
+     */
+    Move pick_best();
+
+    const Position& _position;
+    const Info* _info;
+    const HistoryScore& _history_score;
+
+    Stage _stage;
+    Move _tt_move;
+    Move _killers[2];
+    Move _counter_move;
+
+    Move* _moves;
+    Move* _current;
+    Move* _end;
+    // captures postponed after quiets are stored at the front of the buffer
+    Move* _bad_end;
+    MoveScore _scores[MAX_MOVES];
+};
+
+}  // namespace engine
+
+#endif  // CHESS_ENGINE_MOVE_PICKER_H_
@@ -2,11 +2,10 @@
 
 #include "position.h"
 
+#include <algorithm>
+
 namespace engine
 {
-Move MOVE_LIST[4 * MAX_DEPTH][MAX_MOVES];
-Move TEMP_MOVE_LIST[MAX_MOVES];
-
 Bitboard attack_in_ray(Square sq, Ray ray, Bitboard blockers)
 {
     Bitboard masked_blockers = blockers & RAYS[ray][sq];
@@ -26,29 +25,6 @@ Bitboard attack_in_line(Square sq, Ray ray, Bitboard blockers)
            attack_in_ray(sq, opposite_ray(ray), blockers);
 }
 
-template <Color side>
-Bitboard checkers(const Position& position)
-{
-    const Piece CURRENT_KING = side == WHITE ? W_KING : B_KING;
-    const Direction UPLEFT = side == WHITE ? NORTHWEST : SOUTHEAST;
-    const Direction UPRIGHT = side == WHITE ? NORTHEAST : SOUTHWEST;
-
-    Square king_sq = position.piece_position(CURRENT_KING, 0);
-
-    Bitboard bb = 0ULL;
-
-    bb |= (shift<UPLEFT>(square_bb(king_sq)) |
-           shift<UPRIGHT>(square_bb(king_sq))) &
-          position.pieces(!side, PAWN);
-    bb |= KNIGHT_MASK[king_sq] & position.pieces(!side, KNIGHT);
-    bb |= slider_attack<BISHOP>(king_sq, position.pieces()) &
-          (position.pieces(!side, BISHOP) | position.pieces(!side, QUEEN));
-    bb |= slider_attack<ROOK>(king_sq, position.pieces()) &
-          (position.pieces(!side, ROOK) | position.pieces(!side, QUEEN));
-
-    return bb;
-}
-
 template <Color side>
 Bitboard forbidden_squares(const Position& pos)
 {
@@ -95,7 +71,7 @@ Bitboard forbidden_squares(const Position& pos)
     }
 
 // generate moves for not pinned pawns
-template <Color side>
+template <Color side, MoveGenType type>
 Move* generate_pawn_moves(Bitboard pawns, Bitboard empty, Bitboard push_mask,
                           Bitboard capture_mask, Move* list)
 {
@@ -110,45 +86,53 @@ Move* generate_pawn_moves(Bitboard pawns, Bitboard empty, Bitboard push_mask,
 
     Bitboard pawnsOn7 = pawns & rank7;
     Bitboard pawnsNotOn7 = pawns & ~rank7;
+    Bitboard bb;
+
+    // all promotions are generated together with captures
+    if constexpr (type & CAPTURES)
+    {
+        //// pawns on 7
+        // captures to the right
+        bb = shift<UPRIGHT>(pawnsOn7) & capture_mask;
+        FOR_EACH_BIT(bb,
+                     *list++ = create_promotion(Square(sq - upright), sq, QUEEN);
+                     *list++ = create_promotion(Square(sq - upright), sq, ROOK);
+                     *list++ = create_promotion(Square(sq - upright), sq, BISHOP);
+                     *list++ = create_promotion(Square(sq - upright), sq, KNIGHT);)
+
+        // captures to the left
+        bb = shift<UPLEFT>(pawnsOn7) & capture_mask;
+        FOR_EACH_BIT(bb, *list++ = create_promotion(Square(sq - upleft), sq, QUEEN);
+                     *list++ = create_promotion(Square(sq - upleft), sq, ROOK);
+                     *list++ = create_promotion(Square(sq - upleft), sq, BISHOP);
+                     *list++ = create_promotion(Square(sq - upleft), sq, KNIGHT);)
+
+        // moves
+        bb = shift<UP>(pawnsOn7) & push_mask & empty;
+        FOR_EACH_BIT(bb, *list++ = create_promotion(Square(sq - up), sq, QUEEN);
+                     *list++ = create_promotion(Square(sq - up), sq, ROOK);
+                     *list++ = create_promotion(Square(sq - up), sq, BISHOP);
+                     *list++ = create_promotion(Square(sq - up), sq, KNIGHT);)
+
+        //// pawns not on 7
+        // captures to the right
+        bb = shift<UPRIGHT>(pawnsNotOn7) & capture_mask;
+        FOR_EACH_BIT(bb, *list++ = create_move(Square(sq - upright), sq))
+
+        // captures to the left
+        bb = shift<UPLEFT>(pawnsNotOn7) & capture_mask;
+        FOR_EACH_BIT(bb, *list++ = create_move(Square(sq - upleft), sq))
+    }
 
-    //// pawns on 7
-    // captures to the right
-    Bitboard bb = shift<UPRIGHT>(pawnsOn7) & capture_mask;
-    FOR_EACH_BIT(bb,
-                 *list++ = create_promotion(Square(sq - upright), sq, QUEEN);
-                 *list++ = create_promotion(Square(sq - upright), sq, ROOK);
-                 *list++ = create_promotion(Square(sq - upright), sq, BISHOP);
-                 *list++ = create_promotion(Square(sq - upright), sq, KNIGHT);)
-
-    // captures to the left
-    bb = shift<UPLEFT>(pawnsOn7) & capture_mask;
-    FOR_EACH_BIT(bb, *list++ = create_promotion(Square(sq - upleft), sq, QUEEN);
-                 *list++ = create_promotion(Square(sq - upleft), sq, ROOK);
-                 *list++ = create_promotion(Square(sq - upleft), sq, BISHOP);
-                 *list++ = create_promotion(Square(sq - upleft), sq, KNIGHT);)
-
-    // moves
-    bb = shift<UP>(pawnsOn7) & push_mask & empty;
-    FOR_EACH_BIT(bb, *list++ = create_promotion(Square(sq - up), sq, QUEEN);
-                 *list++ = create_promotion(Square(sq - up), sq, ROOK);
-                 *list++ = create_promotion(Square(sq - up), sq, BISHOP);
-                 *list++ = create_promotion(Square(sq - up), sq, KNIGHT);)
-
-    //// pawns not on 7
-    // captures to the right
-    bb = shift<UPRIGHT>(pawnsNotOn7) & capture_mask;
-    FOR_EACH_BIT(bb, *list++ = create_move(Square(sq - upright), sq))
-
-    // captures to the left
-    bb = shift<UPLEFT>(pawnsNotOn7) & capture_mask;
-    FOR_EACH_BIT(bb, *list++ = create_move(Square(sq - upleft), sq))
-
-    // moves
-    Bitboard pushed_pawns = shift<UP>(pawnsNotOn7) & empty;
-    bb = pushed_pawns & push_mask;
-    FOR_EACH_BIT(bb, *list++ = create_move(Square(sq - up), sq))
-    bb = shift<UP>(pushed_pawns & rank3) & push_mask & empty;
-    FOR_EACH_BIT(bb, *list++ = create_move(Square(sq - 2 * up), sq))
+    if constexpr (type & QUIETS)
+    {
+        // moves
+        Bitboard pushed_pawns = shift<UP>(pawnsNotOn7) & empty;
+        bb = pushed_pawns & push_mask;
+        FOR_EACH_BIT(bb, *list++ = create_move(Square(sq - up), sq))
+        bb = shift<UP>(pushed_pawns & rank3) & push_mask & empty;
+        FOR_EACH_BIT(bb, *list++ = create_move(Square(sq - 2 * up), sq))
+    }
 
     return list;
 }
@@ -206,8 +190,6 @@ Move* generate_enpassant(const Position& pos, Bitboard not_pinned_pawns,
 // 9-11 ray
 using Pin = uint32_t;
 
-Pin PINS[MAX_PINS];
-
 Pin create_pin(Square square, PieceKind piece, Ray ray)
 {
     return ray << 9 | piece << 6 | square;
@@ -246,9 +228,9 @@ Move* generate_piece_moves(Square from, const Position& pos, Bitboard target,
     return list;
 }
 
-Move* generate_king_moves(Square from, Bitboard not_allowed, Move* list)
+Move* generate_king_moves(Square from, Bitboard target, Move* list)
 {
-    Bitboard bb = KING_MASK[from] & ~not_allowed;
+    Bitboard bb = KING_MASK[from] & target;
     FOR_EACH_BIT(bb, *list++ = create_move(from, sq));
     return list;
 }
@@ -314,7 +296,7 @@ Pin* generate_pins(const Position& pos, Pin* list, Bitboard* pinned_bb)
     return list;
 }
 
-template <Color side>
+template <Color side, MoveGenType type>
 Move* generate_pinned_pawn_moves(Square from, Ray ray, const Position& pos,
                                  Bitboard /* target */, Move* list)
 {
@@ -328,6 +310,8 @@ Move* generate_pinned_pawn_moves(Square from, Ray ray, const Position& pos,
 
     if (rank(from) == rank7)
     {
+        if (!(type & CAPTURES)) return list;
+
         switch (ray & 3)
         {
         case 0:
@@ -366,11 +350,11 @@ Move* generate_pinned_pawn_moves(Square from, Ray ray, const Position& pos,
         switch (ray & 3)
         {
         case 0:
-            if (shift<UPLEFT>(square_bb(from)) & pos.pieces(!side))
+            if ((type & CAPTURES) && (shift<UPLEFT>(square_bb(from)) & pos.pieces(!side)))
                 *list++ = create_move(from, Square(static_cast<uint64_t>(from) + static_cast<uint64_t>(UPLEFT)));
             break;
         case 1:
-            if (shift<UP>(square_bb(from)) & ~pos.pieces())
+            if ((type & QUIETS) && (shift<UP>(square_bb(from)) & ~pos.pieces()))
             {
                 *list++ = create_move(from, Square(static_cast<uint64_t>(from) + static_cast<uint64_t>(UP)));
                 if (shift<DOUBLEUP>(square_bb(from) & rank2_bb) & ~pos.pieces())
@@ -378,7 +362,7 @@ Move* generate_pinned_pawn_moves(Square from, Ray ray, const Position& pos,
             }
             break;
         case 2:
-            if (shift<UPRIGHT>(square_bb(from)) & pos.pieces(!side))
+            if ((type & CAPTURES) && (shift<UPRIGHT>(square_bb(from)) & pos.pieces(!side)))
                 *list++ = create_move(from, Square(static_cast<uint64_t>(from) + static_cast<uint64_t>(UPRIGHT)));
             break;
         }
@@ -387,7 +371,7 @@ Move* generate_pinned_pawn_moves(Square from, Ray ray, const Position& pos,
     return list;
 }
 
-template <Color side>
+template <Color side, MoveGenType type>
 Move* generate_pinned_piece_moves(Pin pin, const Position& pos, Bitboard target,
                                   Move* list)
 {
@@ -401,7 +385,7 @@ Move* generate_pinned_piece_moves(Pin pin, const Position& pos, Bitboard target,
     if (piece == KNIGHT) return list;
 
     if (piece == PAWN)
-        return generate_pinned_pawn_moves<side>(from, ray, pos, target, list);
+        return generate_pinned_pawn_moves<side, type>(from, ray, pos, target, list);
 
     if (!allowed_ray(piece, ray)) return list;
 
@@ -413,11 +397,12 @@ Move* generate_pinned_piece_moves(Pin pin, const Position& pos, Bitboard target,
     return list;
 }
 
-template <Color side>
+template <Color side, MoveGenType type>
 Move* generate_legal_moves(const Position& pos, Move* list)
 {
     const Piece C_KING = side == WHITE ? W_KING : B_KING;
-    Bitboard checkers_bb = checkers<side>(pos);
+    assert(side == pos.color());
+    Bitboard checkers_bb = pos.checkers();
 
     Bitboard push_mask;
     Bitboard capture_mask;
@@ -425,11 +410,15 @@ Move* generate_legal_moves(const Position& pos, Move* list)
 
     Square king_sq = pos.piece_position(C_KING, 0);
 
+    // squares the king is allowed to go to
+    Bitboard king_target = ~(attacked | pos.pieces(side));
+    if (!(type & CAPTURES)) king_target &= ~pos.pieces(!side);
+    if (!(type & QUIETS)) king_target &= pos.pieces(!side);
+
     if (checkers_bb)
     {
         if (popcount_more_than_one(checkers_bb))
-            return generate_king_moves(king_sq, attacked | pos.pieces(side),
-                                       list);
+            return generate_king_moves(king_sq, king_target, list);
 
         capture_mask = checkers_bb;
 
@@ -447,14 +436,18 @@ Move* generate_legal_moves(const Position& pos, Move* list)
     }
 
     Bitboard pinned = 0ULL;
-    Pin* pins_start = PINS;
-    Pin* pins_end = generate_pins<side>(pos, pins_start, &pinned);
+    Pin pins[MAX_PINS];
+    Pin* pins_start = pins;
+    Pin* pins_end =
+        pos.pinned() ? generate_pins<side>(pos, pins_start, &pinned) : pins_start;
 
     Bitboard not_pinned_pawns = pos.pieces(side, PAWN) & ~pinned;
-    list = generate_pawn_moves<side>(not_pinned_pawns, ~pos.pieces(), push_mask,
-                                     capture_mask, list);
+    list = generate_pawn_moves<side, type>(not_pinned_pawns, ~pos.pieces(),
+                                           push_mask, capture_mask, list);
 
-    Bitboard target = capture_mask | push_mask;
+    Bitboard target = 0ULL;
+    if (type & CAPTURES) target |= capture_mask;
+    if (type & QUIETS) target |= push_mask;
 
     Bitboard not_pinned_knights = pos.pieces(side, KNIGHT) & ~pinned;
     FOR_EACH_BIT(not_pinned_knights,
@@ -472,18 +465,20 @@ Move* generate_legal_moves(const Position& pos, Move* list)
     FOR_EACH_BIT(not_pinned_queens,
                  list = generate_piece_moves<QUEEN>(sq, pos, target, list));
 
-    if (pos.enpassant_square() != NO_SQUARE)
+    if ((type & CAPTURES) && pos.enpassant_square() != NO_SQUARE)
         list = generate_enpassant<side>(pos, not_pinned_pawns, push_mask,
                                         capture_mask, pos.enpassant_square(),
                                         list);
 
-    list = generate_king_moves(king_sq, attacked | pos.pieces(side), list);
+    list = generate_king_moves(king_sq, king_target, list);
 
     if (!checkers_bb)
     {
         for (Pin* iter = pins_start; iter != pins_end; ++iter)
-            list = generate_pinned_piece_moves<side>(
-                *iter, pos, push_mask | capture_mask, list);
+            list = generate_pinned_piece_moves<side, type>(*iter, pos, target,
+                                                           list);
+
+        if (!(type & QUIETS)) return list;
 
         Bitboard taken_for_castling = attacked | pos.pieces();
 
@@ -519,69 +514,20 @@ Move* generate_legal_moves(const Position& pos, Move* list)
     return list;
 }
 
-template <Color side>
-Move* generate_quiescence(const Position& pos, Move* list)
-{
-    Bitboard checkers_bb = checkers<side>(pos);
-
-    Bitboard pinned = 0ULL;
-    Pin* pins_start = PINS;
-    Pin* pins_end = generate_pins<side>(pos, pins_start, &pinned);
-
-    Bitboard capture_mask = 0ULL;
-
-    if (checkers_bb)
-    {
-        if (popcount_more_than_one(checkers_bb)) return list;
-
-        capture_mask = checkers_bb;
-    }
-    else
-    {
-        capture_mask = pos.pieces(!side) & ~pos.pieces(!side, PAWN);
-    }
-
-    Bitboard not_pinned_pawns = pos.pieces(side, PAWN) & ~pinned;
-    list = generate_pawn_moves<side>(not_pinned_pawns, ~pos.pieces(), 0ULL,
-                                     capture_mask, list);
-
-    Bitboard not_pinned_knights = pos.pieces(side, KNIGHT) & ~pinned;
-    FOR_EACH_BIT(not_pinned_knights, list = generate_piece_moves<KNIGHT>(
-                                         sq, pos, capture_mask, list));
-
-    Bitboard not_pinned_bishops = pos.pieces(side, BISHOP) & ~pinned;
-    FOR_EACH_BIT(not_pinned_bishops, list = generate_piece_moves<BISHOP>(
-                                         sq, pos, capture_mask, list));
-
-    Bitboard not_pinned_rooks = pos.pieces(side, ROOK) & ~pinned;
-    FOR_EACH_BIT(not_pinned_rooks, list = generate_piece_moves<ROOK>(
-                                       sq, pos, capture_mask, list));
-
-    Bitboard not_pinned_queens = pos.pieces(side, QUEEN) & ~pinned;
-    FOR_EACH_BIT(not_pinned_queens, list = generate_piece_moves<QUEEN>(
-                                        sq, pos, capture_mask, list));
-
-    if (!checkers_bb)
-    {
-        for (Pin* iter = pins_start; iter != pins_end; ++iter)
-            list = generate_pinned_piece_moves<side>(*iter, pos, capture_mask,
-                                                     list);
-    }
-
-    return list;
-}
-
+template <MoveGenType type>
 Move* generate_moves(const Position& position, Color side, Move* list)
 {
-    return side == WHITE ? generate_legal_moves<WHITE>(position, list)
-                         : generate_legal_moves<BLACK>(position, list);
+    return side == WHITE ? generate_legal_moves<WHITE, type>(position, list)
+                         : generate_legal_moves<BLACK, type>(position, list);
 }
 
-Move* generate_quiescence_moves(const Position& position, Color side,
-                                Move* list)
+template Move* generate_moves<CAPTURES>(const Position&, Color, Move*);
+template Move* generate_moves<QUIETS>(const Position&, Color, Move*);
+template Move* generate_moves<ALL_MOVES>(const Position&, Color, Move*);
+
+Move* generate_moves(const Position& position, Color side, Move* list)
 {
-    return side == WHITE ? generate_quiescence<WHITE>(position, list)
-                         : generate_quiescence<BLACK>(position, list);
+    return generate_moves<ALL_MOVES>(position, side, list);
 }
 
 Bitboard attacked_squares(const Position& position, Color side)
@@ -624,7 +570,8 @@ uint64_t perft(Position& position, int depth)
 {
     if (depth == 0) return 1;
 
-    Move* begin = MOVE_LIST[depth];
+    Move moves[MAX_MOVES];
+    Move* begin = moves;
     Move* end = generate_moves(position, position.color(), begin);
 
     if (depth == 1) return end - begin;
@@ -633,24 +580,105 @@ uint64_t perft(Position& position, int depth)
     for (Move* it = begin; it != end; ++it)
     {
         Move move = *it;
-        MoveInfo moveinfo = position.do_move(move);
+        position.do_move(move);
 
         sum += perft(position, depth - 1);
 
-        position.undo_move(move, moveinfo);
+        position.undo_move(move);
     }
 
     return sum;
 }
 
+template <Color side>
+bool is_move_legal(const Position& pos, Move move)
+{
+    const Square from_sq = from(move);
+    const Square to_sq = to(move);
+    const Piece piece = pos.piece_at(from_sq);
+    const PieceKind promotion_kind = promotion(move);
+
+    if (piece == NO_PIECE || get_color(piece) != side) return false;
+    if (pos.pieces(side) & square_bb(to_sq)) return false;
+
+    const Bitboard to_bb = square_bb(to_sq);
+    Bitboard occupied = pos.pieces();
+    // enemy pieces removed by the move
+    Bitboard captured = pos.pieces(!side) & to_bb;
+
+    if (make_piece_kind(piece) == PAWN)
+    {
+        const int up = side == WHITE ? 8 : -8;
+        const Rank last_rank = side == WHITE ? RANK_8 : RANK_1;
+        const Rank second_rank = side == WHITE ? RANK_2 : RANK_7;
+
+        if ((rank(to_sq) == last_rank) != (promotion_kind != NO_PIECE_KIND))
+            return false;
+
+        if (pawn_attacks(square_bb(from_sq), side) & to_bb)
+        {
+            if (to_sq == pos.enpassant_square())
+                captured = square_bb(Square(to_sq - up));
+            else if (!captured)
+                return false;
+        }
+        else if (to_sq == from_sq + up)
+        {
+            if (occupied & to_bb) return false;
+        }
+        else if (to_sq == from_sq + 2 * up && rank(from_sq) == second_rank)
+        {
+            if (occupied & (to_bb | square_bb(Square(from_sq + up))))
+                return false;
+        }
+        else
+            return false;
+    }
+    else
+    {
+        if (promotion_kind != NO_PIECE_KIND) return false;
+
+        Bitboard attacks = 0ULL;
+        switch (make_piece_kind(piece))
+        {
+        case KNIGHT: attacks = KNIGHT_MASK[from_sq]; break;
+        case BISHOP: attacks = slider_attack<BISHOP>(from_sq, occupied); break;
+        case ROOK: attacks = slider_attack<ROOK>(from_sq, occupied); break;
+        case QUEEN: attacks = slider_attack<QUEEN>(from_sq, occupied); break;
+        case KING: attacks = KING_MASK[from_sq]; break;
+        default: break;
+        }
+        if (!(attacks & to_bb)) return false;
+    }
+
+    // move is pseudo-legal, check if our king is attacked after it
+    occupied = (occupied ^ square_bb(from_sq) ^ captured) | to_bb;
+    const Square king_sq = make_piece_kind(piece) == KING
+                               ? to_sq
+                               : pos.piece_position(make_piece(side, KING));
+    const Bitboard enemies = pos.pieces(!side) & ~captured;
+
+    return !(((pawn_attacks(square_bb(king_sq), side) & pos.pieces(!side, PAWN)) |
+              (KNIGHT_MASK[king_sq] & pos.pieces(!side, KNIGHT)) |
+              (KING_MASK[king_sq] & pos.pieces(!side, KING)) |
+              (slider_attack<BISHOP>(king_sq, occupied) & pos.pieces(!side, BISHOP, QUEEN)) |
+              (slider_attack<ROOK>(king_sq, occupied) & pos.pieces(!side, ROOK, QUEEN))) &
+             enemies);
+}
+
 bool is_move_legal(const Position& position, Move move)
 {
-    Move* begin = TEMP_MOVE_LIST;
-    Move* end = generate_moves(position, position.color(), begin);
+    if (castling(move) != NO_CASTLING)
+    {
+        // castling is rare enough to check it against generated moves
+        Move moves[MAX_MOVES];
+        Move* begin = moves;
+        Move* end = generate_moves<QUIETS>(position, position.color(), begin);
+        return std::find(begin, end, move) != end;
+    }
 
-    for (Move* it = begin; it != end; ++it)
-        if (*it == move) return true;
-    return false;
+    return position.color() == WHITE ? is_move_legal<WHITE>(position, move)
+                                     : is_move_legal<BLACK>(position, move);
 }
 
 };  // namespace engine
@@ -11,17 +11,29 @@
 
 namespace engine
 {
-extern Move MOVE_LIST[4 * MAX_DEPTH][MAX_MOVES];
-
+enum MoveGenType : uint32_t
+{
+    // captures (including en passant) and all promotions
+    CAPTURES = 1,
+    // remaining moves (including castling)
+    QUIETS = 2,
+    ALL_MOVES = CAPTURES | QUIETS
+};
+
+template <MoveGenType type>
 Move* generate_moves(const Position& position, Color side, Move* list);
 
-Move* generate_quiescence_moves(const Position& position, Color side,
-                                Move* list);
+Move* generate_moves(const Position& position, Color side, Move* list);
 
 Bitboard attacked_squares(const Position& position, Color side);
 
 uint64_t perft(Position& position, int depth);
 
+/**
+ * @brief Checks if move is legal in the position.
+ * Works for any move value (e.g. taken from the transposition table
+ * or the killer slots) without generating all moves.
+ */
 bool is_move_legal(const Position& position, Move move);
 
 }  // namespace engine
@@ -0,0 +1,375 @@
+#include "nnue.h"
+
+#include "position.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace engine
+{
+namespace nnue
+{
+namespace
+{
+constexpr char FILE_MAGIC[8] = {'C', 'P', 'P', 'N', 'N', 'U', 'E', 0};
+
+struct Network
+{
+    int half_dimensions = 0;
+
+    std::vector<int16_t> feature_bias;
+    std::vector<int16_t> feature_weights;
+
+    std::vector<int32_t> hidden1_bias;
+    std::vector<int16_t> hidden1_weights;
+    std::vector<int32_t> hidden2_bias;
+    std::vector<int16_t> hidden2_weights;
+    int32_t output_bias = 0;
+    std::vector<int16_t> output_weights;
+};
+
+Network network;
+// incremented on every (un)load, 0 means that there is no network
+uint32_t network_generation = 0;
+uint32_t last_generation = 0;
+
+Square orient(Color perspective, Square square)
+{
+    return perspective == WHITE ? square : Square(square ^ 56);
+}
+
+int feature_index(Color perspective, Square king_square, Piece piece,
+                  Square square)
+{
+    const int piece_index = (get_piece_kind(piece) - 1) +
+                            (get_color(piece) == perspective ? 0 : 5);
+    return (static_cast<int>(orient(perspective, king_square)) * 10 + piece_index) *
+               static_cast<int>(SQUARE_NUM) +
+           static_cast<int>(orient(perspective, square));
+}
+
+const int16_t* feature_row(int index)
+{
+    return network.feature_weights.data() +
+           static_cast<std::size_t>(index) * network.half_dimensions;
+}
+
+template <typename T>
+bool read(std::istream& stream, T* data, std::size_t count)
+{
+    stream.read(reinterpret_cast<char*>(data),
+                static_cast<std::streamsize>(count * sizeof(T)));
+    return static_cast<bool>(stream);
+}
+
+template <typename T>
+bool read(std::istream& stream, std::vector<T>& data, std::size_t count)
+{
+    data.resize(count);
+    return read(stream, data.data(), count);
+}
+
+void clipped_relu(const int32_t* input, int16_t* output, int size)
+{
+    for (int i = 0; i < size; ++i)
+        output[i] = static_cast<int16_t>(
+            std::clamp(input[i] >> WEIGHT_SHIFT, 0, ACTIVATION_MAX));
+}
+
+}  // namespace
+
+bool load(const std::string& path)
+{
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream) return false;
+    const std::size_t file_size = static_cast<std::size_t>(stream.tellg());
+    stream.seekg(0);
+
+    char magic[8];
+    uint32_t version, half_dimensions;
+    if (!read(stream, magic, 8) || !read(stream, &version, 1) ||
+        !read(stream, &half_dimensions, 1))
+        return false;
+
+    if (std::memcmp(magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+        version != FILE_VERSION || half_dimensions == 0 ||
+        half_dimensions > MAX_HALF_DIMENSIONS ||
+        half_dimensions % HALF_DIMENSIONS_STEP != 0)
+        return false;
+
+    const std::size_t n = half_dimensions;
+    const std::size_t expected_size =
+        sizeof(FILE_MAGIC) + 2 * sizeof(uint32_t) +
+        sizeof(int16_t) * (n + FEATURE_DIMENSIONS * n) +
+        sizeof(int32_t) * HIDDEN_DIMENSIONS +
+        sizeof(int16_t) * HIDDEN_DIMENSIONS * 2 * n +
+        sizeof(int32_t) * HIDDEN_DIMENSIONS +
+        sizeof(int16_t) * HIDDEN_DIMENSIONS * HIDDEN_DIMENSIONS +
+        sizeof(int32_t) + sizeof(int16_t) * HIDDEN_DIMENSIONS;
+    if (file_size != expected_size) return false;
+
+    Network loaded;
+    loaded.half_dimensions = static_cast<int>(n);
+    if (!read(stream, loaded.feature_bias, n) ||
+        !read(stream, loaded.feature_weights, FEATURE_DIMENSIONS * n) ||
+        !read(stream, loaded.hidden1_bias, HIDDEN_DIMENSIONS) ||
+        !read(stream, loaded.hidden1_weights, HIDDEN_DIMENSIONS * 2 * n) ||
+        !read(stream, loaded.hidden2_bias, HIDDEN_DIMENSIONS) ||
+        !read(stream, loaded.hidden2_weights, HIDDEN_DIMENSIONS * HIDDEN_DIMENSIONS) ||
+        !read(stream, &loaded.output_bias, 1) ||
+        !read(stream, loaded.output_weights, HIDDEN_DIMENSIONS))
+        return false;
+
+    network = std::move(loaded);
+    network_generation = ++last_generation;
+    return true;
+}
+
+void unload()
+{
+    network = Network();
+    network_generation = 0;
+}
+
+bool is_loaded()
+{
+    return network_generation != 0;
+}
+
+bool is_current(const Accumulator& accumulator)
+{
+    return network_generation != 0 && accumulator.generation == network_generation;
+}
+
+void refresh(const Position& position, Accumulator& accumulator, Color perspective)
+{
+    const int n = network.half_dimensions;
+    int16_t* values = accumulator.values[perspective];
+    std::copy_n(network.feature_bias.data(), n, values);
+    if (position.number_of_pieces(make_piece(perspective, KING)) == 0) return;
+
+    const Square king_square = position.piece_position(make_piece(perspective, KING));
+    for (Color side : {WHITE, BLACK})
+    {
+        for (PieceKind kind : {PAWN, KNIGHT, BISHOP, ROOK, QUEEN})
+        {
+            const Piece piece = make_piece(side, kind);
+            for (int i = 0; i < position.number_of_pieces(piece); ++i)
+                add_row(values,
+                        feature_row(feature_index(perspective, king_square, piece,
+                                                  position.piece_position(piece, i))),
+                        n);
+        }
+    }
+}
+
+void refresh(const Position& position, Accumulator& accumulator)
+{
+    accumulator.generation = network_generation;
+    if (network_generation == 0) return;
+
+    refresh(position, accumulator, WHITE);
+    refresh(position, accumulator, BLACK);
+}
+
+void add_piece(Accumulator& accumulator, Piece piece, Square square,
+               const Square king_squares[COLOR_NUM])
+{
+    const int n = network.half_dimensions;
+    for (Color perspective : {WHITE, BLACK})
+        add_row(accumulator.values[perspective],
+                feature_row(feature_index(perspective, king_squares[perspective],
+                                          piece, square)),
+                n);
+}
+
+void remove_piece(Accumulator& accumulator, Piece piece, Square square,
+                  const Square king_squares[COLOR_NUM])
+{
+    const int n = network.half_dimensions;
+    for (Color perspective : {WHITE, BLACK})
+        sub_row(accumulator.values[perspective],
+                feature_row(feature_index(perspective, king_squares[perspective],
+                                          piece, square)),
+                n);
+}
+
+Value evaluate(const Position& position)
+{
+    const int n = network.half_dimensions;
+
+    Accumulator fresh;
+    const Accumulator* accumulator = &position.accumulator();
+    if (!is_current(*accumulator))
+    {
+        refresh(position, fresh);
+        accumulator = &fresh;
+    }
+
+    // side to move goes first
+    alignas(32) int16_t input[2 * MAX_HALF_DIMENSIONS];
+    const Color us = position.color();
+    for (int i = 0; i < n; ++i)
+    {
+        input[i] = static_cast<int16_t>(
+            std::clamp<int>(accumulator->values[us][i], 0, ACTIVATION_MAX));
+        input[n + i] = static_cast<int16_t>(
+            std::clamp<int>(accumulator->values[!us][i], 0, ACTIVATION_MAX));
+    }
+
+    alignas(32) int32_t hidden1[HIDDEN_DIMENSIONS];
+    alignas(32) int16_t hidden1_out[HIDDEN_DIMENSIONS];
+    affine(input, 2 * n, network.hidden1_weights.data(),
+           network.hidden1_bias.data(), hidden1, HIDDEN_DIMENSIONS);
+    clipped_relu(hidden1, hidden1_out, HIDDEN_DIMENSIONS);
+
+    alignas(32) int32_t hidden2[HIDDEN_DIMENSIONS];
+    alignas(32) int16_t hidden2_out[HIDDEN_DIMENSIONS];
+    affine(hidden1_out, HIDDEN_DIMENSIONS, network.hidden2_weights.data(),
+           network.hidden2_bias.data(), hidden2, HIDDEN_DIMENSIONS);
+    clipped_relu(hidden2, hidden2_out, HIDDEN_DIMENSIONS);
+
+    int32_t output;
+    affine(hidden2_out, HIDDEN_DIMENSIONS, network.output_weights.data(),
+           &network.output_bias, &output, 1);
+
+    return static_cast<Value>(output / OUTPUT_SCALE);
+}
+
+void affine_scalar(const int16_t* input, int input_size,
+                   const int16_t* weights, const int32_t* bias,
+                   int32_t* output, int output_size)
+{
+    for (int i = 0; i < output_size; ++i)
+    {
+        int32_t sum = bias[i];
+        const int16_t* row = weights + i * input_size;
+        for (int j = 0; j < input_size; ++j) sum += row[j] * input[j];
+        output[i] = sum;
+    }
+}
+
+void add_row_scalar(int16_t* values, const int16_t* row, int size)
+{
+    for (int i = 0; i < size; ++i) values[i] = static_cast<int16_t>(values[i] + row[i]);
+}
+
+void sub_row_scalar(int16_t* values, const int16_t* row, int size)
+{
+    for (int i = 0; i < size; ++i) values[i] = static_cast<int16_t>(values[i] - row[i]);
+}
+
+#if defined(__AVX2__)
+
+void affine(const int16_t* input, int input_size, const int16_t* weights,
+            const int32_t* bias, int32_t* output, int output_size)
+{
+    for (int i = 0; i < output_size; ++i)
+    {
+        const int16_t* row = weights + i * input_size;
+        __m256i sum = _mm256_setzero_si256();
+        for (int j = 0; j < input_size; j += 16)
+        {
+            const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + j));
+            const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + j));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(in, w));
+        }
+        __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                                       _mm256_extracti128_si256(sum, 1));
+        sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0x4E));
+        sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0xB1));
+        output[i] = bias[i] + _mm_cvtsi128_si32(sum128);
+    }
+}
+
+void add_row(int16_t* values, const int16_t* row, int size)
+{
+    for (int i = 0; i < size; i += 16)
+    {
+        __m256i* v = reinterpret_cast<__m256i*>(values + i);
+        const __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+        _mm256_storeu_si256(v, _mm256_add_epi16(_mm256_loadu_si256(v), r));
+    }
+}
+
+void sub_row(int16_t* values, const int16_t* row, int size)
+{
+    for (int i = 0; i < size; i += 16)
+    {
+        __m256i* v = reinterpret_cast<__m256i*>(values + i);
+        const __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+        _mm256_storeu_si256(v, _mm256_sub_epi16(_mm256_loadu_si256(v), r));
+    }
+}
+
+#elif defined(__SSE2__)
+
+void affine(const int16_t* input, int input_size, const int16_t* weights,
+            const int32_t* bias, int32_t* output, int output_size)
+{
+    for (int i = 0; i < output_size; ++i)
+    {
+        const int16_t* row = weights + i * input_size;
+        __m128i sum = _mm_setzero_si128();
+        for (int j = 0; j < input_size; j += 8)
+        {
+            const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + j));
+            const __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + j));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(in, w));
+        }
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+        output[i] = bias[i] + _mm_cvtsi128_si32(sum);
+    }
+}
+
+void add_row(int16_t* values, const int16_t* row, int size)
+{
+    for (int i = 0; i < size; i += 8)
+    {
+        __m128i* v = reinterpret_cast<__m128i*>(values + i);
+        const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        _mm_storeu_si128(v, _mm_add_epi16(_mm_loadu_si128(v), r));
+    }
+}
+
+void sub_row(int16_t* values, const int16_t* row, int size)
+{
+    for (int i = 0; i < size; i += 8)
+    {
+        __m128i* v = reinterpret_cast<__m128i*>(values + i);
+        const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        _mm_storeu_si128(v, _mm_sub_epi16(_mm_loadu_si128(v), r));
+    }
+}
+
+#else
+
+void affine(const int16_t* input, int input_size, const int16_t* weights,
+            const int32_t* bias, int32_t* output, int output_size)
+{
+    affine_scalar(input, input_size, weights, bias, output, output_size);
+}
+
+void add_row(int16_t* values, const int16_t* row, int size)
+{
+    add_row_scalar(values, row, size);
+}
+
+void sub_row(int16_t* values, const int16_t* row, int size)
+{
+    sub_row_scalar(values, row, size);
+}
+
+#endif
+
+}  // namespace nnue
+}  // namespace engine
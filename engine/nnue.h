@@ -0,0 +1,124 @@
+#ifndef CHESS_ENGINE_NNUE_H_
+#define CHESS_ENGINE_NNUE_H_
+
+#include "types.h"
+#include "value.h"
+
+#include <cstdint>
+#include <string>
+
+namespace engine
+{
+class Position;
+
+/**
+ * Optional neural network evaluation (NNUE).
+ *
+ * Network:
+ *   HalfKP features (own king square x non-king piece x square, 40960 inputs
+ *   per perspective) -> 2 x N accumulator -> 32 -> 32 -> 1
+ * Hidden layers use clipped ReLU, all weights are int16.
+ *
+ * First layer (accumulator) is kept in Position and updated incrementally
+ * by every piece change, a king move refreshes the king side's perspective.
+ *
+ * File format (little-endian):
+ *   char magic[8] = "CPPNNUE", uint32 version, uint32 N,
+ *   int16 feature_bias[N], int16 feature_weights[40960][N],
+ *   int32 hidden1_bias[32], int16 hidden1_weights[32][2 * N],
+ *   int32 hidden2_bias[32], int16 hidden2_weights[32][32],
+ *   int32 output_bias, int16 output_weights[32]
+ */
+namespace nnue
+{
+constexpr int FEATURE_DIMENSIONS = SQUARE_NUM * 10 * SQUARE_NUM;
+constexpr int MAX_HALF_DIMENSIONS = 256;
+constexpr int HIDDEN_DIMENSIONS = 32;
+// N has to be a multiple of it
+constexpr int HALF_DIMENSIONS_STEP = 16;
+
+constexpr uint32_t FILE_VERSION = 1;
+
+// clipped ReLU output is in [0, ACTIVATION_MAX]
+constexpr int ACTIVATION_MAX = 127;
+// hidden layer sums are divided by 2^WEIGHT_SHIFT before activation
+constexpr int WEIGHT_SHIFT = 6;
+// network output is divided by it to get Value
+constexpr int OUTPUT_SCALE = 16;
+
+struct alignas(32) Accumulator
+{
+    int16_t values[COLOR_NUM][MAX_HALF_DIMENSIONS];
+    // generation of the network it was computed with (0 - not computed)
+    uint32_t generation = 0;
+};
+
+/**
+ * @brief Loads network from file, returns false (and keeps
+ * the current network) if the file is missing or malformed.
+ */
+bool load(const std::string& path);
+
+/**
+ * @brief Goes back to the classical evaluation.
+ */
+void unload();
+
+bool is_loaded();
+
+/**
+ * @brief Checks if accumulator was computed with the current network.
+ */
+bool is_current(const Accumulator& accumulator);
+
+/**
+ * @brief Computes accumulator of position from scratch.
+ */
+void refresh(const Position& position, Accumulator& accumulator);
+
+/**
+ * @brief Recomputes only one perspective (after its king moved).
+ */
+void refresh(const Position& position, Accumulator& accumulator,
+             Color perspective);
+
+/**
+ * @brief Incremental updates for a non-king piece appearing on
+ * or disappearing from square.
+ */
+void add_piece(Accumulator& accumulator, Piece piece, Square square,
+               const Square king_squares[COLOR_NUM]);
+void remove_piece(Accumulator& accumulator, Piece piece, Square square,
+                  const Square king_squares[COLOR_NUM]);
+
+/**
+ * @brief Evaluates position from the side to move point of view.
+ * Position's accumulator is used if it is current, otherwise
+ * it is computed from scratch.
+ */
+Value evaluate(const Position& position);
+
+// Kernels, SIMD versions (AVX2 or SSE2, when available) and scalar fallbacks.
+
+/**
+ * @brief output[i] = bias[i] + sum_j weights[i * input_size + j] * input[j]
+ * input_size has to be a multiple of 16.
+ */
+void affine(const int16_t* input, int input_size, const int16_t* weights,
+            const int32_t* bias, int32_t* output, int output_size);
+void affine_scalar(const int16_t* input, int input_size,
+                   const int16_t* weights, const int32_t* bias,
+                   int32_t* output, int output_size);
+
+/**
+ * @brief values[i] += row[i] (or -= for sub), size has to be a multiple of 16.
+ */
+void add_row(int16_t* values, const int16_t* row, int size);
+void sub_row(int16_t* values, const int16_t* row, int size);
+void add_row_scalar(int16_t* values, const int16_t* row, int size);
+void sub_row_scalar(int16_t* values, const int16_t* row, int size);
+
+}  // namespace nnue
+}  // namespace engine
+
+#endif  // CHESS_ENGINE_NNUE_H_
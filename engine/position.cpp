@@ -1,11 +1,14 @@
 #include "position.h"
 
 #include "bitboard.h"
+#include "bithacks.h"
 #include "movegen.h"
+#include "psqt.h"
 #include "types.h"
 #include "utils.h"
 #include "zobrist_hash.h"
 
+#include <algorithm>
 #include <optional>
 #include <sstream>
 
@@ -47,14 +50,21 @@ const std::string Position::STARTPOS_FEN =
 
 Position::Position() : Position(STARTPOS_FEN) {}
 
-Position::Position(std::string fen) : _zobrist_hash()
+Position::Position(std::string fen)
 {
+    StateInfo state;
+    _state = &state;
+
     _current_side = WHITE;
-    std::fill_n(_board, SQUARE_NUM, NO_PIECE);
+    std::fill_n(_board.squares, SQUARE_NUM, NO_PIECE);
     std::fill_n(_piece_count, PIECE_NUM, 0);
-    std::fill_n(_by_piece_kind_bb, PIECE_KIND_NUM, 0ULL);
-    std::fill_n(_by_color_bb, COLOR_NUM, 0ULL);
-    _castling_rights = NO_CASTLING;
+    std::fill_n(_piece_index, SQUARE_NUM, 0);
+    std::fill_n(_board.by_piece_kind, PIECE_KIND_NUM, 0ULL);
+    std::fill_n(_board.by_color, COLOR_NUM, 0ULL);
+    _state->zobrist_hash = HashKey();
+    _state->psq_score = Score();
+    _state->castling_rights = NO_CASTLING;
+    _state->captured_piece = NO_PIECE;
     set_enpassant_square(NO_SQUARE);
 
     std::istringstream stream(fen);
@@ -77,10 +87,12 @@ Position::Position(std::string fen) : _zobrist_hash()
         else
         {
             Piece piece = char_to_piece[c];
-            _board[square] = piece;
-            _by_color_bb[get_color(piece)] |= square_bb(square);
-            _by_piece_kind_bb[get_piece_kind(piece)] |= square_bb(square);
+            _board.squares[square] = piece;
+            _board.by_color[get_color(piece)] |= square_bb(square);
+            _board.by_piece_kind[get_piece_kind(piece)] |= square_bb(square);
+            _piece_index[square] = _piece_count[piece];
             _piece_position[piece][_piece_count[piece]++] = square;
+            _state->psq_score += PIECE_SQUARE_SCORE[piece][square];
 
             ++square;
         }
@@ -94,10 +106,10 @@ Position::Position(std::string fen) : _zobrist_hash()
     {
         switch (c)
         {
-        case 'K': _castling_rights |= W_OO; break;
-        case 'Q': _castling_rights |= W_OOO; break;
-        case 'k': _castling_rights |= B_OO; break;
-        case 'q': _castling_rights |= B_OOO; break;
+        case 'K': _state->castling_rights |= W_OO; break;
+        case 'Q': _state->castling_rights |= W_OOO; break;
+        case 'k': _state->castling_rights |= B_OO; break;
+        case 'q': _state->castling_rights |= B_OOO; break;
         }
     }
 
@@ -105,27 +117,70 @@ Position::Position(std::string fen) : _zobrist_hash()
     set_enpassant_square(token == "-" ? NO_SQUARE : notationToSquare(token));
 
     stream >> _ply_counter;
-    _half_move_counter = uint8_t(_ply_counter);
+    _state->half_move_counter = uint16_t(_ply_counter);
+    _state->plies_from_null = 0;
     stream >> _ply_counter;
 
     _ply_counter = 2 * _ply_counter - 1 + !!(_current_side == BLACK);
 
-    _zobrist_hash.init(*this);
+    _state->zobrist_hash.init(*this);
+    update_check_info();
+    refresh_accumulator();
+
+    const uint64_t key = hash();
+    _history = std::make_unique<GameHistory>();
+    _history->reset(state, &key, &key + 1);
+    _state = _history->top();
+}
+
+Position::Position(const Position& other) : _history(std::make_unique<GameHistory>())
+{
+    *this = other;
+}
+
+Position& Position::operator=(const Position& other)
+{
+    if (this == &other) return *this;
+
+    _current_side = other._current_side;
+    _ply_counter = other._ply_counter;
+
+    _board = other._board;
+    std::copy_n(&other._piece_position[0][0], PIECE_NUM * 10, &_piece_position[0][0]);
+    std::copy_n(other._piece_count, PIECE_NUM, _piece_count);
+    std::copy_n(other._piece_index, SQUARE_NUM, _piece_index);
+
+    _accumulator = other._accumulator;
+
+    // positions before the last irreversible move can't be repeated
+    const std::vector<uint64_t>& keys = other._history->keys();
+    const size_t reversible = std::min(keys.size(), size_t(other.half_moves()) + 1);
+    if (!_history) _history = std::make_unique<GameHistory>();
+    _history->reset(*other._state, keys.data() + (keys.size() - reversible),
+                    keys.data() + keys.size());
+    _state = _history->top();
 
-    _history[0] = _zobrist_hash.get_key();
-    _history_counter = 1;
+    return *this;
+}
+
+void GameHistory::reset(const StateInfo& state, const uint64_t* keys_begin,
+                        const uint64_t* keys_end)
+{
+    _states.clear();
+    _states.push_back(state);
+    _keys.assign(keys_begin, keys_end);
 }
 
 bool Position::operator==(const Position& other) const
 {
     // first check hashes
-    if (_zobrist_hash.get_key() != other._zobrist_hash.get_key()) return false;
+    if (hash() != other.hash()) return false;
 
     if (_current_side != other._current_side) return false;
-    if (_castling_rights != other._castling_rights) return false;
-    if (_enpassant_square != other._enpassant_square) return false;
+    if (castling_rights() != other.castling_rights()) return false;
+    if (enpassant_square() != other.enpassant_square()) return false;
     for (Square square = SQ_A1; square <= SQ_H8; ++square)
-        if (_board[square] != other._board[square]) return false;
+        if (piece_at(square) != other.piece_at(square)) return false;
     return true;
 }
 
@@ -161,25 +216,26 @@ std::string Position::fen() const
         if (rank > 0) stream << "/";
     }
     stream << " " << (_current_side == WHITE ? "w" : "b") << " ";
-    if (_castling_rights != NO_CASTLING)
+    const Castling castling = castling_rights();
+    if (castling != NO_CASTLING)
     {
-        if (_castling_rights & W_OO) stream << "K";
-        if (_castling_rights & W_OOO) stream << "Q";
-        if (_castling_rights & B_OO) stream << "k";
-        if (_castling_rights & B_OOO) stream << "q";
+        if (castling & W_OO) stream << "K";
+        if (castling & W_OOO) stream << "Q";
+        if (castling & B_OO) stream << "k";
+        if (castling & B_OOO) stream << "q";
     }
     else
         stream << "-";
     stream << " ";
-    if (_enpassant_square != NO_SQUARE)
+    if (enpassant_square() != NO_SQUARE)
     {
-        stream << char('a' + file(_enpassant_square));
-        stream << char('1' + rank(_enpassant_square));
+        stream << char('a' + file(enpassant_square()));
+        stream << char('1' + rank(enpassant_square()));
     }
     else
         stream << "-";
 
-    stream << " " << uint32_t(_half_move_counter) << " "
+    stream << " " << half_moves() << " "
            << (_ply_counter - 1) / 2 + 1;
 
     return stream.str();
@@ -190,25 +246,66 @@ bool Position::is_draw() const
     return rule50() || threefold_repetition() || !enough_material();
 }
 
+int Position::reversible_plies() const
+{
+    // keys aren't stored for null moves, so positions before
+    // the last one aren't at the expected distance
+    const int plies = std::min(half_moves(), uint32_t(_state->plies_from_null));
+    return std::min(plies, int(_history->keys().size()) - 1);
+}
+
 bool Position::threefold_repetition() const
 {
+    const std::vector<uint64_t>& keys = _history->keys();
+    const int end = reversible_plies();
     int count = 1;
-    for (int i = _history_counter - 2; i >= 0; --i)
-        if (_history[i] == _zobrist_hash.get_key())
+    for (int i = 4; i <= end; i += 2)
+        if (keys[keys.size() - 1 - i] == hash())
             if (++count == 3) return true;
     return false;
 }
 
 bool Position::is_repeated() const
 {
-    for (int i = _history_counter - 2; i >= 0; --i)
-        if (_history[i] == _zobrist_hash.get_key()) return true;
+    const std::vector<uint64_t>& keys = _history->keys();
+    const int end = reversible_plies();
+    for (int i = 4; i <= end; i += 2)
+        if (keys[keys.size() - 1 - i] == hash()) return true;
+    return false;
+}
+
+bool Position::has_upcoming_repetition() const
+{
+    const std::vector<uint64_t>& keys = _history->keys();
+    const int end = reversible_plies();
+    for (int i = 3; i <= end; i += 2)
+    {
+        // positions differ only by placement of a single piece
+        const uint64_t move_key = hash() ^ keys[keys.size() - 1 - i];
+        int index = zobrist::cuckoo_h1(move_key);
+        if (zobrist::CUCKOO_KEYS[index] != move_key)
+        {
+            index = zobrist::cuckoo_h2(move_key);
+            if (zobrist::CUCKOO_KEYS[index] != move_key) continue;
+        }
+
+        const Move move = zobrist::CUCKOO_MOVES[index];
+        const Square s1 = from(move);
+        const Square s2 = to(move);
+        const Bitboard between = LINES[s1][s2] & ~(square_bb(s1) | square_bb(s2));
+        if (between & pieces()) continue;
+
+        // both directions are stored in the same entry,
+        // the move has to be made by the side to move
+        const Piece piece = piece_at(piece_at(s1) != NO_PIECE ? s1 : s2);
+        if (get_color(piece) == _current_side) return true;
+    }
     return false;
 }
 
 bool Position::rule50() const
 {
-    return int(_half_move_counter) >= 100;
+    return int(half_moves()) >= 100;
 }
 
 bool Position::enough_material() const
@@ -330,22 +427,22 @@ bool Position::move_gives_check(Move move) const
 
 Bitboard Position::pieces() const
 {
-    return _by_color_bb[WHITE] | _by_color_bb[BLACK];
+    return _board.by_color[WHITE] | _board.by_color[BLACK];
 }
 
 Bitboard Position::pieces(Color c) const
 {
-    return _by_color_bb[c];
+    return _board.by_color[c];
 }
 
 Bitboard Position::pieces(PieceKind p) const
 {
-    return _by_piece_kind_bb[p];
+    return _board.by_piece_kind[p];
 }
 
 Bitboard Position::pieces(Color c, PieceKind p) const
 {
-    return _by_color_bb[c] & _by_piece_kind_bb[p];
+    return _board.by_color[c] & _board.by_piece_kind[p];
 }
 
 Bitboard Position::pieces(Piece p) const
@@ -363,90 +460,112 @@ Bitboard Position::pieces(Color c, PieceKind p1, PieceKind p2) const
     return pieces(c, p1) | pieces(c, p2);
 }
 
+template <bool UNDO>
 void Position::add_piece(Piece piece, Square square)
 {
-    ASSERT(_board[square] == NO_PIECE);
+    ASSERT(piece_at(square) == NO_PIECE);
 
-    _board[square] = piece;
-    _by_color_bb[get_color(piece)] |= square_bb(square);
-    _by_piece_kind_bb[get_piece_kind(piece)] |= square_bb(square);
+    _board.squares[square] = piece;
+    _board.by_color[get_color(piece)] |= square_bb(square);
+    _board.by_piece_kind[get_piece_kind(piece)] |= square_bb(square);
+    _piece_index[square] = _piece_count[piece];
     _piece_position[piece][_piece_count[piece]] = square;
     _piece_count[piece] += 1;
+    update_accumulator(piece, square, true);
 
-    _zobrist_hash.toggle_piece(piece, square);
+    if (UNDO) return;
+    _state->psq_score += PIECE_SQUARE_SCORE[piece][square];
+    _state->zobrist_hash.toggle_piece(piece, square);
+    _state->zobrist_hash.toggle_material(piece, _piece_count[piece] - 1);
 }
 
+template <bool UNDO>
 void Position::remove_piece(Square square)
 {
-    ASSERT(_board[square] != NO_PIECE);
+    ASSERT(piece_at(square) != NO_PIECE);
 
-    Piece piece = _board[square];
-    _board[square] = NO_PIECE;
-    _by_color_bb[get_color(piece)] ^= square_bb(square);
-    _by_piece_kind_bb[get_piece_kind(piece)] ^= square_bb(square);
+    Piece piece = piece_at(square);
+    _board.squares[square] = NO_PIECE;
+    _board.by_color[get_color(piece)] ^= square_bb(square);
+    _board.by_piece_kind[get_piece_kind(piece)] ^= square_bb(square);
 
-    for (int i = 0; i < _piece_count[piece] - 1; ++i)
-    {
-        if (_piece_position[piece][i] == square)
-        {
-            int pos = _piece_count[piece] - 1;
-            _piece_position[piece][i] = _piece_position[piece][pos];
-            break;
-        }
-    }
+    // last piece of the list takes the slot of the removed one
     _piece_count[piece] -= 1;
-
-    _zobrist_hash.toggle_piece(piece, square);
+    const uint8_t index = _piece_index[square];
+    const uint8_t last_square = _piece_position[piece][_piece_count[piece]];
+    _piece_position[piece][index] = last_square;
+    _piece_index[last_square] = index;
+    update_accumulator(piece, square, false);
+
+    if (UNDO) return;
+    _state->psq_score -= PIECE_SQUARE_SCORE[piece][square];
+    _state->zobrist_hash.toggle_piece(piece, square);
+    _state->zobrist_hash.toggle_material(piece, _piece_count[piece]);
 }
 
+template <bool UNDO>
 void Position::move_piece(Square from, Square to)
 {
-    ASSERT_WITH_MSG(_board[from] != NO_PIECE, "There is no piece at %d", from);
-    ASSERT_WITH_MSG(_board[to] == NO_PIECE, "Piece at %d is %d", to, _board[to]);
+    ASSERT_WITH_MSG(piece_at(from) != NO_PIECE, "There is no piece at %d", from);
+    ASSERT_WITH_MSG(piece_at(to) == NO_PIECE, "Piece at %d is %d", to, piece_at(to));
 
-    Piece piece = _board[from];
-    _board[from] = NO_PIECE;
-    _board[to] = piece;
+    Piece piece = piece_at(from);
+    _board.squares[from] = NO_PIECE;
+    _board.squares[to] = piece;
 
     Bitboard change = square_bb(from) | square_bb(to);
-    _by_color_bb[get_color(piece)] ^= change;
-    _by_piece_kind_bb[get_piece_kind(piece)] ^= change;
+    _board.by_color[get_color(piece)] ^= change;
+    _board.by_piece_kind[get_piece_kind(piece)] ^= change;
+
+    _piece_index[to] = _piece_index[from];
+    _piece_position[piece][_piece_index[to]] = to;
 
-    for (int i = 0; i < _piece_count[piece]; ++i)
+    if (get_piece_kind(piece) == KING)
     {
-        if (_piece_position[piece][i] == from)
-        {
-            _piece_position[piece][i] = to;
-            break;
-        }
+        // all features of this side depend on its king square
+        if (nnue::is_current(_accumulator))
+            nnue::refresh(*this, _accumulator, get_color(piece));
+    }
+    else
+    {
+        update_accumulator(piece, from, false);
+        update_accumulator(piece, to, true);
     }
 
-    _zobrist_hash.move_piece(piece, from, to);
+    if (UNDO) return;
+    _state->psq_score += PIECE_SQUARE_SCORE[piece][to] - PIECE_SQUARE_SCORE[piece][from];
+    _state->zobrist_hash.move_piece(piece, from, to);
 }
 
-void Position::change_current_side()
+void Position::update_accumulator(Piece piece, Square square, bool added)
 {
-    _zobrist_hash.flip_side();
-    _current_side = !_current_side;
+    if (!nnue::is_current(_accumulator)) return;
+
+    const Square king_squares[COLOR_NUM] = {piece_position(W_KING),
+                                            piece_position(B_KING)};
+    if (added)
+        nnue::add_piece(_accumulator, piece, square, king_squares);
+    else
+        nnue::remove_piece(_accumulator, piece, square, king_squares);
 }
 
-MoveInfo Position::do_move(Move move)
+void Position::do_move(Move move)
 {
+    _state = _history->push();
+    _state->captured_piece = NO_PIECE;
+    _state->plies_from_null++;
+
     Color side = _current_side;
-    change_current_side();
+    _current_side = !side;
+    _state->zobrist_hash.flip_side();
     _ply_counter++;
 
-    PieceKind captured = NO_PIECE_KIND;
-    Castling prev_castling = _castling_rights;
-    Square prev_enpassant_sq = _enpassant_square;
-    bool enpassant = false;
-    uint8_t hm_counter = _half_move_counter;
-
-    _zobrist_hash.clear_enpassant();
+    const Square prev_enpassant_sq = _state->enpassant_square;
+    _state->zobrist_hash.clear_enpassant();
 
     if (castling(move) != NO_CASTLING)
     {
-        _half_move_counter = 0;
+        _state->half_move_counter = 0;
 
         Rank rank = side == WHITE ? RANK_1 : RANK_8;
         if (castling(move) == KING_CASTLING)
@@ -460,36 +579,36 @@ MoveInfo Position::do_move(Move move)
             move_piece(make_square(rank, FILE_A), make_square(rank, FILE_D));
         }
 
-        _castling_rights &= !CASTLING_RIGHTS[side];
-        _zobrist_hash.set_castling(_castling_rights);
+        _state->castling_rights &= !CASTLING_RIGHTS[side];
+        _state->zobrist_hash.set_castling(_state->castling_rights);
         set_enpassant_square(NO_SQUARE);
     }
     else
     {
-        Piece moved_piece = _board[from(move)];
-        Piece captured_piece = _board[to(move)];
-        captured = make_piece_kind(captured_piece);
+        Piece moved_piece = piece_at(from(move));
+        Piece captured_piece = piece_at(to(move));
 
         ASSERT(moved_piece != NO_PIECE);
 
         if (get_piece_kind(moved_piece) != PAWN &&
             make_piece_kind(captured_piece) == NO_PIECE_KIND)
-            _half_move_counter++;
+            _state->half_move_counter++;
         else
-            _half_move_counter = 0;
+            _state->half_move_counter = 0;
 
         // enpassant
         if (get_piece_kind(moved_piece) == PAWN &&
-            to(move) == _enpassant_square)
+            to(move) == prev_enpassant_sq)
         {
             move_piece(from(move), to(move));
             Square captured_square =
                 Square(to(move) + (side == WHITE ? -8 : 8));
+            _state->captured_piece = piece_at(captured_square);
             remove_piece(captured_square);
-            enpassant = true;
         }
         else
         {
+            _state->captured_piece = captured_piece;
             if (captured_piece != NO_PIECE) remove_piece(to(move));
 
             if (promotion(move) != NO_PIECE_KIND)
@@ -500,21 +619,22 @@ MoveInfo Position::do_move(Move move)
             else
                 move_piece(from(move), to(move));
 
+            Castling& castling_rights = _state->castling_rights;
             if (get_piece_kind(moved_piece) == KING)
-                _castling_rights &= !CASTLING_RIGHTS[side];
+                castling_rights &= !CASTLING_RIGHTS[side];
             if (get_piece_kind(moved_piece) == ROOK &&
                 from(move) == KING_SIDE_ROOK_SQUARE[side])
-                _castling_rights &= !(CASTLING_RIGHTS[side] & KING_CASTLING);
+                castling_rights &= !(CASTLING_RIGHTS[side] & KING_CASTLING);
             if (get_piece_kind(moved_piece) == ROOK &&
                 from(move) == QUEEN_SIDE_ROOK_SQUARE[side])
-                _castling_rights &= !(CASTLING_RIGHTS[side] & QUEEN_CASTLING);
+                castling_rights &= !(CASTLING_RIGHTS[side] & QUEEN_CASTLING);
             if (make_piece_kind(captured_piece) == ROOK &&
                 to(move) == KING_SIDE_ROOK_SQUARE[!side])
-                _castling_rights &= !(CASTLING_RIGHTS[!side] & KING_CASTLING);
+                castling_rights &= !(CASTLING_RIGHTS[!side] & KING_CASTLING);
             if (make_piece_kind(captured_piece) == ROOK &&
                 to(move) == QUEEN_SIDE_ROOK_SQUARE[!side])
-                _castling_rights &= !(CASTLING_RIGHTS[!side] & QUEEN_CASTLING);
-            _zobrist_hash.set_castling(_castling_rights);
+                castling_rights &= !(CASTLING_RIGHTS[!side] & QUEEN_CASTLING);
+            _state->zobrist_hash.set_castling(castling_rights);
         }
 
         Rank enpassant_rank = (side == WHITE) ? RANK_4 : RANK_5;
@@ -523,108 +643,122 @@ MoveInfo Position::do_move(Move move)
             rank(to(move)) == enpassant_rank)
         {
             set_enpassant_square(Square(to(move) + (side == WHITE ? -8 : 8)));
-            _zobrist_hash.set_enpassant(file(_enpassant_square));
+            _state->zobrist_hash.set_enpassant(file(_state->enpassant_square));
         }
         else
             set_enpassant_square(NO_SQUARE);
     }
 
-    assert(_history_counter < MAX_PLIES);
-    _history[_history_counter++] = _zobrist_hash.get_key();
+    update_check_info();
 
-    return create_moveinfo(captured, prev_castling, prev_enpassant_sq,
-                           enpassant, hm_counter);
+    _history->push_key(hash());
 }
 
-void Position::undo_move(Move move, MoveInfo moveinfo)
+void Position::undo_move(Move move)
 {
-    change_current_side();
+    _current_side = !_current_side;
     Color side = _current_side;
 
     _ply_counter--;
 
-    _castling_rights = last_castling(moveinfo);
-    _zobrist_hash.set_castling(_castling_rights);
-
-    set_enpassant_square(last_enpassant_square(moveinfo));
-    if (_enpassant_square == NO_SQUARE)
-        _zobrist_hash.clear_enpassant();
-    else
-        _zobrist_hash.set_enpassant(file(_enpassant_square));
-
-    _half_move_counter = half_move_counter(moveinfo);
-
     if (castling(move) != NO_CASTLING)
     {
         Rank rank = side == WHITE ? RANK_1 : RANK_8;
         if (castling(move) == KING_CASTLING)
         {
-            move_piece(make_square(rank, FILE_G), make_square(rank, FILE_E));
-            move_piece(make_square(rank, FILE_F), make_square(rank, FILE_H));
+            move_piece<true>(make_square(rank, FILE_G), make_square(rank, FILE_E));
+            move_piece<true>(make_square(rank, FILE_F), make_square(rank, FILE_H));
         }
         else  // castling(move) == QUEEN_CASTLING
         {
-            move_piece(make_square(rank, FILE_C), make_square(rank, FILE_E));
-            move_piece(make_square(rank, FILE_D), make_square(rank, FILE_A));
+            move_piece<true>(make_square(rank, FILE_C), make_square(rank, FILE_E));
+            move_piece<true>(make_square(rank, FILE_D), make_square(rank, FILE_A));
         }
     }
     else
     {
-        Piece captured = make_piece(!side, captured_piece(moveinfo));
-
-        if (enpassant(moveinfo))
-        {
-            Square captured_square =
-                Square(to(move) + (side == WHITE ? -8 : 8));
-            add_piece(make_piece(!side, PAWN), captured_square);
-        }
+        const Piece captured = _state->captured_piece;
+        Square captured_square = to(move);
 
         if (promotion(move) != NO_PIECE_KIND)
         {
-            add_piece(make_piece(side, PAWN), from(move));
-            remove_piece(to(move));
+            remove_piece<true>(to(move));
+            add_piece<true>(make_piece(side, PAWN), from(move));
         }
         else
-            move_piece(to(move), from(move));
+        {
+            if (to(move) == _state[-1].enpassant_square &&
+                get_piece_kind(piece_at(to(move))) == PAWN)
+                captured_square = Square(to(move) + (side == WHITE ? -8 : 8));
+            move_piece<true>(to(move), from(move));
+        }
 
-        if (captured != NO_PIECE) add_piece(captured, to(move));
+        if (captured != NO_PIECE) add_piece<true>(captured, captured_square);
     }
 
-    _history_counter--;
+    // hash, score, castling rights etc. come back with the previous state
+    _state = _history->pop();
+    _history->pop_key();
 }
 
 void Position::set_enpassant_square(Square sq)
 {
     ASSERT(sq == NO_SQUARE || rank(sq) == RANK_3 || rank(sq) == RANK_6);
-    _enpassant_square = sq;
+    _state->enpassant_square = sq;
+}
+
+void Position::update_check_info()
+{
+    const Color side = _current_side;
+    const Square king_sq = piece_position(make_piece(side, KING));
+    const Bitboard occupied = pieces();
+
+    _state->checkers = attackers_to(king_sq, occupied) & pieces(!side);
+
+    // enemy sliders that would attack the king on an empty board,
+    // own piece is pinned when it's the only one between
+    Bitboard snipers =
+        (pseudoattacks<BISHOP>(king_sq) & pieces(!side, BISHOP, QUEEN)) |
+        (pseudoattacks<ROOK>(king_sq) & pieces(!side, ROOK, QUEEN));
+    Bitboard pinned = 0ULL;
+    while (snipers)
+    {
+        const Square sniper_sq = Square(pop_lsb(&snipers));
+        const Bitboard between = LINES[king_sq][sniper_sq] & occupied &
+                                 ~(square_bb(king_sq) | square_bb(sniper_sq));
+        if (between && !popcount_more_than_one(between)) pinned |= between;
+    }
+    _state->pinned = pinned & pieces(side);
 }
 
-MoveInfo Position::do_null_move()
+void Position::do_null_move()
 {
-    change_current_side();
+    _state = _history->push();
+    _state->captured_piece = NO_PIECE;
+    _state->half_move_counter++;
+    _state->plies_from_null = 0;
+
+    _current_side = !_current_side;
+    _state->zobrist_hash.flip_side();
     _ply_counter++;
-    _half_move_counter++;
 
-    Square enpassant_sq = _enpassant_square;
     set_enpassant_square(NO_SQUARE);
-    _zobrist_hash.clear_enpassant();
+    _state->zobrist_hash.clear_enpassant();
 
-    return create_moveinfo(NO_PIECE_KIND, NO_CASTLING, enpassant_sq, false, 0);
+    update_check_info();
 }
 
-void Position::undo_null_move(MoveInfo moveinfo)
+void Position::undo_null_move()
 {
-    change_current_side();
+    _current_side = !_current_side;
     _ply_counter--;
-    _half_move_counter--;
-
-    set_enpassant_square(last_enpassant_square(moveinfo));
-    if (_enpassant_square != NO_SQUARE)
-        _zobrist_hash.set_enpassant(file(_enpassant_square));
+    _state = _history->pop();
 }
 
 bool Position::is_in_check(Color side) const
 {
+    if (side == _current_side) return checkers();
+
     const Square king_sq = piece_position(make_piece(side, KING));
 
     if (pawn_attacks(square_bb(king_sq), side) & pieces(!side, PAWN))
@@ -639,9 +773,90 @@ bool Position::is_in_check(Color side) const
     return false;
 }
 
+Bitboard Position::attackers_to(Square square, Bitboard occupied) const
+{
+    const Bitboard bb = square_bb(square);
+    return (pawn_attacks(bb, WHITE) & pieces(BLACK, PAWN)) |
+           (pawn_attacks(bb, BLACK) & pieces(WHITE, PAWN)) |
+           (KNIGHT_MASK[square] & pieces(KNIGHT)) |
+           (KING_MASK[square] & pieces(KING)) |
+           (slider_attack<BISHOP>(square, occupied) & (pieces(BISHOP) | pieces(QUEEN))) |
+           (slider_attack<ROOK>(square, occupied) & (pieces(ROOK) | pieces(QUEEN)));
+}
+
+Value Position::see(Move move) const
+{
+    // king can be "captured" only if the other side runs out of attackers
+    constexpr Value SEE_VALUE[PIECE_KIND_NUM] = {
+        0, PIECE_VALUE[PAWN].mg, PIECE_VALUE[KNIGHT].mg, PIECE_VALUE[BISHOP].mg,
+        PIECE_VALUE[ROOK].mg, PIECE_VALUE[QUEEN].mg, 2 * VALUE_ALL_PIECES};
+
+    if (castling(move) != NO_CASTLING) return 0;
+
+    const Square from_sq = from(move);
+    const Square to_sq = to(move);
+    const PieceKind promotion_kind = promotion(move);
+
+    Bitboard occupied = pieces() ^ square_bb(from_sq);
+    PieceKind captured = make_piece_kind(piece_at(to_sq));
+    PieceKind attacker = make_piece_kind(piece_at(from_sq));
+
+    if (attacker == PAWN && to_sq == enpassant_square())
+    {
+        captured = PAWN;
+        occupied ^= square_bb(Square(to_sq - (color() == WHITE ? 8 : -8)));
+    }
+
+    // gain[i] - material won by side making i-th capture,
+    // assuming that the exchange stops after it
+    Value gain[32];
+    int depth = 0;
+    gain[0] = SEE_VALUE[captured];
+    if (promotion_kind != NO_PIECE_KIND)
+    {
+        gain[0] += SEE_VALUE[promotion_kind] - SEE_VALUE[PAWN];
+        attacker = promotion_kind;
+    }
+
+    Bitboard attackers = attackers_to(to_sq, occupied) & occupied;
+    Color side = !color();
+
+    while (true)
+    {
+        const Bitboard side_attackers = attackers & pieces(side);
+        if (!side_attackers) break;
+
+        PieceKind next = PAWN;
+        while (!(side_attackers & pieces(next))) ++next;
+
+        depth++;
+        gain[depth] = SEE_VALUE[attacker] - gain[depth - 1];
+        // side to move loses material whether it captures or not
+        if (std::max(-gain[depth - 1], gain[depth]) < 0) break;
+
+        occupied ^= square_bb(Square(lsb(side_attackers & pieces(next))));
+        // add sliders which were behind the piece that captured
+        if (next == PAWN || next == BISHOP || next == QUEEN)
+            attackers |= slider_attack<BISHOP>(to_sq, occupied) & (pieces(BISHOP) | pieces(QUEEN));
+        if (next == ROOK || next == QUEEN)
+            attackers |= slider_attack<ROOK>(to_sq, occupied) & (pieces(ROOK) | pieces(QUEEN));
+        attackers &= occupied;
+
+        attacker = next;
+        side = !side;
+    }
+
+    // each side can choose not to capture
+    for (; depth > 0; --depth)
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+
+    return gain[0];
+}
+
 bool Position::is_checkmate() const
 {
-    Move* begin = MOVE_LIST[0];
+    Move moves[MAX_MOVES];
+    Move* begin = moves;
     Move* end = generate_moves(*this, _current_side, begin);
 
     return (begin == end) && is_in_check(_current_side);
@@ -649,7 +864,8 @@ bool Position::is_checkmate() const
 
 bool Position::is_stalemate() const
 {
-    Move* begin = MOVE_LIST[0];
+    Move moves[MAX_MOVES];
+    Move* begin = moves;
     Move* end = generate_moves(*this, _current_side, begin);
 
     return (begin == end) && !is_in_check(_current_side);
@@ -724,13 +940,13 @@ Move Position::parse_uci(const std::string& str)
 
     move = create_promotion(from, to, promotion);
 
-    if (make_piece_kind(_board[from]) == KING && from == SQ_E1 && to == SQ_G1)
+    if (make_piece_kind(piece_at(from)) == KING && from == SQ_E1 && to == SQ_G1)
         move = create_castling(KING_CASTLING);
-    if (make_piece_kind(_board[from]) == KING && from == SQ_E1 && to == SQ_C1)
+    if (make_piece_kind(piece_at(from)) == KING && from == SQ_E1 && to == SQ_C1)
         move = create_castling(QUEEN_CASTLING);
-    if (make_piece_kind(_board[from]) == KING && from == SQ_E8 && to == SQ_G8)
+    if (make_piece_kind(piece_at(from)) == KING && from == SQ_E8 && to == SQ_G8)
         move = create_castling(KING_CASTLING);
-    if (make_piece_kind(_board[from]) == KING && from == SQ_E8 && to == SQ_C8)
+    if (make_piece_kind(piece_at(from)) == KING && from == SQ_E8 && to == SQ_C8)
         move = create_castling(QUEEN_CASTLING);
 
     return move;
@@ -855,7 +1071,7 @@ std::string Position::san_without_check(Move move) const
 
     Bitboard capturing_bb = pieces(!_current_side);
     capturing_bb |=
-        moved_piece == PAWN ? square_bb(_enpassant_square) : no_squares_bb;
+        moved_piece == PAWN ? square_bb(enpassant_square()) : no_squares_bb;
     if (square_bb(to(move)) & capturing_bb)
     {
         if (moved_piece == PAWN && s == "")
@@ -3,7 +3,9 @@
 
 #include "bitboard.h"
 #include "move_bitboards.h"
+#include "nnue.h"
 #include "types.h"
+#include "value.h"
 #include "zobrist_hash.h"
 
 #include <bits/stdint-uintn.h>
@@ -11,12 +13,89 @@
 #include <cinttypes>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <regex>
 #include <string>
 #include <vector>
 
 namespace engine
 {
+/*
+ * Part of the position that can't be restored by replaying
+ * a move backwards (or is cheaper to copy than to recompute).
+ * Position keeps a stack of them, one per move played.
+ */
+struct StateInfo
+{
+    HashKey zobrist_hash;
+    Score psq_score;
+
+    Castling castling_rights;
+    Square enpassant_square;
+    uint16_t half_move_counter;
+    // moves played since the last null move
+    uint16_t plies_from_null;
+
+    // piece captured by the move that led to this state
+    Piece captured_piece;
+
+    // pieces giving check to the side to move
+    Bitboard checkers;
+    // pieces of the side to move pinned to its king
+    Bitboard pinned;
+};
+
+/*
+ * States and hashes of positions reached during the game. Kept outside
+ * of Position (which only points to it), so copying a position doesn't
+ * copy the whole game; grows with the number of moves played.
+ */
+class GameHistory
+{
+  public:
+    /*
+     * Starts history at given state, keys are hashes of previous
+     * positions (oldest first) used for repetition detection.
+     */
+    void reset(const StateInfo& state, const uint64_t* keys_begin,
+               const uint64_t* keys_end);
+
+    StateInfo* top() { return &_states.back(); }
+
+    // new state is a copy of the current one, pointers
+    // to previous states are invalidated when the buffer grows
+    StateInfo* push()
+    {
+        _states.push_back(_states.back());
+        return &_states.back();
+    }
+    StateInfo* pop()
+    {
+        _states.pop_back();
+        return &_states.back();
+    }
+
+    const std::vector<uint64_t>& keys() const { return _keys; }
+    void push_key(uint64_t key) { _keys.push_back(key); }
+    void pop_key() { _keys.pop_back(); }
+
+  private:
+    std::vector<StateInfo> _states;
+    std::vector<uint64_t> _keys;
+};
+
+/*
+ * Piece placement, the part of a position changed by every move.
+ * Squares fill a single cache line and the whole struct is a few
+ * of them, so it's cheap to copy for copy-make or to store in bulk.
+ */
+struct alignas(64) Board
+{
+    uint8_t squares[SQUARE_NUM];
+    Bitboard by_piece_kind[PIECE_KIND_NUM];
+    Bitboard by_color[COLOR_NUM];
+};
+
 class Position
 {
   public:
@@ -31,11 +110,11 @@ class Position
     // generate fen string for position
     std::string fen() const;
 
-    MoveInfo do_move(Move move);
-    void undo_move(Move move, MoveInfo moveinfo);
+    void do_move(Move move);
+    void undo_move(Move move);
 
-    MoveInfo do_null_move();
-    void undo_null_move(MoveInfo moveinfo);
+    void do_null_move();
+    void undo_null_move();
 
     bool is_in_check(Color side) const;
     bool is_checkmate() const;
@@ -43,7 +122,7 @@ class Position
 
     Color color() const { return _current_side; }
 
-    uint32_t half_moves() const { return _half_move_counter; }
+    uint32_t half_moves() const { return _state->half_move_counter; }
     uint32_t ply_count() const { return _ply_counter; }
 
     bool is_draw() const;
@@ -55,24 +134,71 @@ class Position
     bool move_is_capture(Move move) const;
     bool move_gives_check(Move move) const;
 
+    /*
+     * Static exchange evaluation, material balance (in middlegame
+     * piece values) after all captures on the destination square
+     * of the move, when both sides capture with the least valuable
+     * piece first and can stop capturing at any time.
+     * Pins are not taken into account.
+     */
+    Value see(Move move) const;
+
+    /*
+     * Returns pieces of both sides attacking given square,
+     * slider attacks are computed for given occupancy.
+     */
+    Bitboard attackers_to(Square square, Bitboard occupied) const;
+
     /*
      * Checks if current position was ever reached
      * (faster then checking for threefold_repetition).
+     * Like threefold_repetition, only positions since the last
+     * irreversible move and null move with the same side to move
+     * are checked.
      */
     bool is_repeated() const;
 
-    Piece piece_at(Square square) const { return _board[square]; }
+    /*
+     * Checks if the side to move has a move going back to a position
+     * reached before (so it can get at least a draw by repetition).
+     */
+    bool has_upcoming_repetition() const;
+
+    Piece piece_at(Square square) const { return Piece(_board.squares[square]); }
     int number_of_pieces(Piece piece) const { return _piece_count[piece]; }
     Square piece_position(Piece piece, int pos = 0) const
     {
-        return _piece_position[piece][pos];
+        return Square(_piece_position[piece][pos]);
     }
 
-    Castling castling_rights() const { return _castling_rights; }
-    Square enpassant_square() const { return _enpassant_square; }
+    const Board& board() const { return _board; }
 
-    uint64_t hash() const { return _zobrist_hash.get_key(); }
-    uint64_t pawn_hash() const { return _zobrist_hash.get_pawnkey(); }
+    Castling castling_rights() const { return _state->castling_rights; }
+    Square enpassant_square() const { return _state->enpassant_square; }
+
+    /*
+     * Piece captured by the last move (NO_PIECE if it wasn't a capture).
+     */
+    Piece captured_piece() const { return _state->captured_piece; }
+
+    /*
+     * Pieces giving check to the side to move.
+     */
+    Bitboard checkers() const { return _state->checkers; }
+
+    /*
+     * Pieces of the side to move pinned to its king.
+     */
+    Bitboard pinned() const { return _state->pinned; }
+
+    uint64_t hash() const { return _state->zobrist_hash.get_key(); }
+    uint64_t pawn_hash() const { return _state->zobrist_hash.get_pawnkey(); }
+
+    /*
+     * Key depending only on number of pieces of each type,
+     * see zobrist::material_key().
+     */
+    uint64_t material_hash() const { return _state->zobrist_hash.get_materialkey(); }
 
     Bitboard pieces() const;
     Bitboard pieces(Color c) const;
@@ -84,6 +210,23 @@ class Position
 
     PieceCountVector get_pcv() const;
 
+    /*
+     * Sum of PIECE_SQUARE_SCORE (material and piece-square terms)
+     * of all pieces from white's point of view, updated incrementally.
+     */
+    Score psq_score() const { return _state->psq_score; }
+
+    /*
+     * First layer of the NNUE network, updated incrementally
+     * while the network it was computed with stays loaded.
+     */
+    const nnue::Accumulator& accumulator() const { return _accumulator; }
+
+    /*
+     * Recomputes accumulator, has to be called after a network is loaded.
+     */
+    void refresh_accumulator() { nnue::refresh(*this, _accumulator); }
+
     /*
      * Return number of non-pawn pieces for given side.
      */
@@ -95,35 +238,54 @@ class Position
     std::string uci(Move move) const;
     std::string san(Move move) const;
 
+    /*
+     * Copy starts its own game history at the current position,
+     * it keeps only hashes of positions since the last irreversible
+     * move (earlier ones can't be repeated) and moves played before
+     * the copy was made can't be undone in it.
+     */
+    Position(const Position& other);
+    Position& operator=(const Position& other);
+
+    Position(Position&& other) = default;
+    Position& operator=(Position&& other) = default;
+
   private:
+    // When undoing a move (UNDO = true) hash and score
+    // are not updated, previous state is restored instead.
+    template <bool UNDO = false>
     void add_piece(Piece piece, Square square);
+    template <bool UNDO = false>
     void remove_piece(Square square);
+    template <bool UNDO = false>
     void move_piece(Square from, Square to);
 
-    void change_current_side();
+    void update_accumulator(Piece piece, Square square, bool added);
+
     void set_enpassant_square(Square sq);
 
+    // fills checkers and pinned of the current state
+    void update_check_info();
+
+    // number of previous plies that can be checked for repetitions
+    int reversible_plies() const;
+
     std::string san_without_check(Move move) const;
 
     Color _current_side;
 
-    uint8_t _half_move_counter;
     int32_t _ply_counter;
 
-    Piece _board[SQUARE_NUM];
-    Square _piece_position[PIECE_NUM][10];
-    int _piece_count[PIECE_NUM];
-
-    Bitboard _by_piece_kind_bb[PIECE_KIND_NUM];
-    Bitboard _by_color_bb[COLOR_NUM];
-
-    Castling _castling_rights;
-    Square _enpassant_square;
+    Board _board;
+    uint8_t _piece_position[PIECE_NUM][10];
+    uint8_t _piece_count[PIECE_NUM];
+    // slot in the piece list of the piece on given square
+    uint8_t _piece_index[SQUARE_NUM];
 
-    HashKey _zobrist_hash;
+    nnue::Accumulator _accumulator;
 
-    int32_t _history_counter;
-    uint64_t _history[MAX_PLIES];
+    std::unique_ptr<GameHistory> _history;
+    StateInfo* _state;
 };
 
 std::ostream& operator<<(std::ostream& stream, const Position& position);
@@ -0,0 +1,57 @@
+#include "psqt.h"
+
+#include "bitboard.h"
+#include "bithacks.h"
+#include "move_bitboards.h"
+
+namespace engine
+{
+Score PIECE_SQUARE_SCORE[PIECE_NUM][SQUARE_NUM];
+
+namespace psqt
+{
+
+namespace
+{
+
+template <Color side>
+Score square_score(PieceKind piece_kind, Square sq)
+{
+    Score score = PIECE_VALUE[piece_kind];
+
+    if (piece_kind == PAWN)
+    {
+        const Bitboard attacks = pawn_attacks<side>(square_bb(sq));
+        score += popcount(attacks & opponents_center_bb[side]) *
+                 PAWN_CONTROL_CENTER_BONUS;
+    }
+    else if (piece_kind == KNIGHT)
+    {
+        const Bitboard attacking = KNIGHT_MASK[sq];
+        score += CONTROL_SPACE[KNIGHT] *
+                 Value(popcount(attacking & OPPONENT_RANKS_BB[side]));
+        score += CONTROL_CENTER_KNIGHT * Value(popcount(attacking & center_bb));
+    }
+
+    return score;
+}
+
+}  // namespace
+
+void init()
+{
+    for (PieceKind piece_kind = PAWN; piece_kind <= KING; ++piece_kind)
+    {
+        for (Square sq = SQ_A1; sq <= SQ_H8; ++sq)
+        {
+            PIECE_SQUARE_SCORE[make_piece(WHITE, piece_kind)][sq] =
+                square_score<WHITE>(piece_kind, sq);
+            PIECE_SQUARE_SCORE[make_piece(BLACK, piece_kind)][sq] =
+                Score() - square_score<BLACK>(piece_kind, sq);
+        }
+    }
+}
+
+}  // namespace psqt
+
+}  // namespace engine
@@ -0,0 +1,29 @@
+#ifndef CHESS_ENGINE_PSQT_H_
+#define CHESS_ENGINE_PSQT_H_
+
+#include "types.h"
+#include "value.h"
+
+namespace engine
+{
+/**
+ * @brief Piece-square table, material value of the piece plus
+ * evaluation terms which depend only on the square of the piece.
+ * Black pieces have negative scores, so that the sum over all pieces
+ * is from white's point of view.
+ */
+extern Score PIECE_SQUARE_SCORE[PIECE_NUM][SQUARE_NUM];
+
+namespace psqt
+{
+
+/**
+ * @brief Fills PIECE_SQUARE_SCORE, requires move_bitboards::init().
+ */
+void init();
+
+}  // namespace psqt
+
+}  // namespace engine
+
+#endif  // CHESS_ENGINE_PSQT_H_
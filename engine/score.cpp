@@ -3,10 +3,13 @@
 #include "bitboard.h"
 #include "bithacks.h"
 #include "endgame.h"
+#include "nnue.h"
 #include "position.h"
 #include "position_bitboards.h"
+#include "psqt.h"
 #include "types.h"
 
+#include <algorithm>
 #include <iomanip>
 
 namespace engine
@@ -29,11 +32,34 @@ const Value MAX_PIECE_WEIGTHS =
     2 * (2 * PIECE_WEIGHTS[KNIGHT] + 2 * PIECE_WEIGHTS[BISHOP] +
          2 * PIECE_WEIGHTS[ROOK] + 1 * PIECE_WEIGHTS[QUEEN]);
 
-PositionScorer::PositionScorer() : _pawn_hash_table(), _weight(-1) {}
+void EvalCache::resize(std::size_t size_mb)
+{
+    std::size_t num_entries = size_mb * 1024 * 1024 / sizeof(uint64_t);
+    // index is taken from the lower bits of the key
+    while (num_entries & (num_entries - 1)) num_entries &= num_entries - 1;
+
+    _entries.assign(num_entries, 0ULL);
+    _mask = num_entries == 0 ? 0 : num_entries - 1;
+    _stats = Stats();
+}
+
+void EvalCache::clear()
+{
+    std::fill(_entries.begin(), _entries.end(), 0ULL);
+    _stats = Stats();
+}
+
+PositionScorer::PositionScorer()
+    : _eval_cache(), _pawn_hash_table(), _material_hash_table(), _weight(-1)
+{
+    _eval_cache.resize(EvalCache::DEFAULT_SIZE_MB);
+}
 
 void PositionScorer::clear()
 {
+    _eval_cache.clear();
     _pawn_hash_table.clear();
+    _material_hash_table.clear();
 }
 
 Value PositionScorer::combine(const Score& score)
@@ -45,8 +71,20 @@ Value PositionScorer::combine(const Score& score)
 
 Value PositionScorer::score(const Position& position)
 {
-    Value endgameValue = endgame::score(position);
-    if (endgameValue != VALUE_NONE) return endgameValue;
+    Value value;
+    if (_eval_cache.probe(position.hash(), value)) return value;
+
+    value = evaluate(position);
+    _eval_cache.store(position.hash(), value);
+    return value;
+}
+
+Value PositionScorer::evaluate(const Position& position)
+{
+    const MaterialEntry& material = probe_material(position);
+    if (material.endgame) return material.endgame->score(position);
+
+    if (nnue::is_loaded()) return nnue::evaluate(position);
 
     /* if (!popcount_more_than_one(position.pieces(WHITE))) */
     /*     return endgame::score_endgame<BLACK>(position); */
@@ -56,15 +94,28 @@ Value PositionScorer::score(const Position& position)
     setup<WHITE>(position);
     setup<BLACK>(position);
 
-    _weight = game_phase_weight(position);
+    _weight = material.weight;
 
     Score pieces = score_pieces(position);
     Score pawns = score_pawns(position);
-    Value value = combine(pawns + pieces);
+    // material and piece-square terms are updated incrementally by position
+    Value value = combine(position.psq_score() + pawns + pieces);
 
     return position.color() == WHITE ? value : -value;
 }
 
+const MaterialEntry& PositionScorer::probe_material(const Position& position)
+{
+    const uint64_t key = position.material_hash();
+    bool found = false;
+    auto entry = _material_hash_table.probe(key, found);
+
+    if (!found)
+        _material_hash_table.insert(
+            key, MaterialEntry{endgame::find(position), game_phase_weight(position)});
+    return entry->value;
+}
+
 template <Color side>
 void PositionScorer::setup(const Position& position)
 {
@@ -153,7 +204,7 @@ Score PositionScorer::score_pieces_for_side(const Position& position)
 
         for (int i = 0; i < no_pieces; ++i)
         {
-            Score score = PIECE_VALUE[KNIGHT];
+            Score score;
             Square sq = position.piece_position(piece, i);
             Bitboard attacking = KNIGHT_MASK[sq];
 
@@ -161,11 +212,6 @@ Score PositionScorer::score_pieces_for_side(const Position& position)
             {
                 score += SAFE_KNIGHT;
             }
-            score += CONTROL_SPACE[KNIGHT] *
-                     Value(popcount(attacking & OPPONENT_RANKS_BB[side]));
-            score +=
-                CONTROL_CENTER_KNIGHT * Value(popcount(attacking & center_bb));
-
             score +=
                 KING_PROTECTOR_PENALTY[KNIGHT] * Value(distance(ownKing, sq));
             score += KING_ATTACKER_PENALTY[KNIGHT] *
@@ -195,7 +241,7 @@ Score PositionScorer::score_pieces_for_side(const Position& position)
 
         for (int i = 0; i < no_pieces; ++i)
         {
-            Score score = PIECE_VALUE[BISHOP];
+            Score score;
             Square sq = position.piece_position(piece, i);
             Bitboard attacking = slider_attack<BISHOP>(sq, position.pieces());
 
@@ -242,7 +288,7 @@ Score PositionScorer::score_pieces_for_side(const Position& position)
 
         for (int i = 0; i < no_pieces; ++i)
         {
-            Score score = PIECE_VALUE[ROOK];
+            Score score;
             Square sq = position.piece_position(piece, i);
 
             Bitboard blockers =
@@ -295,7 +341,7 @@ Score PositionScorer::score_pieces_for_side(const Position& position)
 
         for (int i = 0; i < no_pieces; ++i)
         {
-            Score score = PIECE_VALUE[QUEEN];
+            Score score;
             Square sq = position.piece_position(piece, i);
 
             Bitboard blockers =
@@ -479,7 +525,7 @@ Score PositionScorer::score_pawns_for_side(const Position& position)
 
     for (int i = 0; i < num_pawns; ++i)
     {
-        Score score = PIECE_VALUE[PAWN];
+        Score score;
         Square sq = position.piece_position(pawn, i);
 
         Rank r = rank(sq);
@@ -503,8 +549,6 @@ Score PositionScorer::score_pawns_for_side(const Position& position)
                             (!(opposed ^ leverPush) &&
                              popcount(phalanx) >= popcount(leverPush));
 
-        score += popcount(attacks & opponents_center_bb[side]) *
-                 PAWN_CONTROL_CENTER_BONUS;
         if (doubled) score += DOUBLE_PAWN_PENALTY;
         if (support | phalanx)
         {
@@ -602,13 +646,27 @@ Bitboard PositionScorer::get_real_possible_moves(const Position& position,
     return moves;
 }
 
-void PositionScorer::print_stats()
+void PositionScorer::print_stats(const Position& position)
 {
 #define TERM(white, black) \
     white << "|" << black << "|" << (white - black) << "|"
 
-    Score total_white = _side_scores[WHITE] + _piece_scores[WHITE][PAWN];
-    Score total_black = _side_scores[BLACK] + _piece_scores[BLACK][PAWN];
+    // piece-square scores from the point of view of piece owner
+    Score square_psq[SQUARE_NUM];
+    Score psq[COLOR_NUM];
+    for (Square sq = SQ_A1; sq <= SQ_H8; ++sq)
+    {
+        const Piece piece = position.piece_at(sq);
+        if (piece == NO_PIECE) continue;
+
+        square_psq[sq] = get_color(piece) == WHITE
+                             ? PIECE_SQUARE_SCORE[piece][sq]
+                             : Score() - PIECE_SQUARE_SCORE[piece][sq];
+        psq[get_color(piece)] += square_psq[sq];
+    }
+
+    Score total_white = psq[WHITE] + _side_scores[WHITE] + _piece_scores[WHITE][PAWN];
+    Score total_black = psq[BLACK] + _side_scores[BLACK] + _piece_scores[BLACK][PAWN];
 
     const std::string pieceChar = " PNBRQKpnbrqk";
     const std::string colorReset = "\033[m";
@@ -632,7 +690,7 @@ void PositionScorer::print_stats()
         std::cout << horizontalLine << std::endl;
         for (File file = FILE_A; file <= FILE_H; ++file)
         {
-            Piece piece = _square_scores[make_square(rank, file)].first;
+            Piece piece = position.piece_at(make_square(rank, file));
             std::cout << "|  " << sideColor[get_color(piece)]
                       << pieceKindColor[get_piece_kind(piece)]
                       << pieceChar[piece] << "  " << colorReset;
@@ -640,7 +698,12 @@ void PositionScorer::print_stats()
         std::cout << "|" << std::endl;
         for (File file = FILE_A; file <= FILE_H; ++file)
         {
-            const auto [piece, score] = _square_scores[make_square(rank, file)];
+            const Square sq = make_square(rank, file);
+            const Piece piece = position.piece_at(sq);
+            const Score score =
+                square_psq[sq] + (_square_scores[sq].first == piece
+                                      ? _square_scores[sq].second
+                                      : Score());
             std::cout << "|" << sideColor[get_color(piece)]
                       << pieceKindColor[get_piece_kind(piece)] << std::setw(5)
                       << std::setfill(' ')
@@ -662,6 +725,8 @@ void PositionScorer::print_stats()
               << std::endl
               << "+---------+--------------+--------------+--------------+"
               << std::endl
+              << "|    PSQT |" << TERM(psq[WHITE], psq[BLACK])
+              << std::endl
               << "|   PAWNS |"
               << TERM(_piece_scores[WHITE][PAWN], _piece_scores[BLACK][PAWN])
               << std::endl
@@ -6,22 +6,131 @@
 #include "types.h"
 #include "value.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 namespace engine
 {
+namespace endgame
+{
+class EndgameBase;
+}
+
 using PawnHashMap = HashMap<uint64_t, Score, 512 * 512>;
 
+/**
+ * @brief Evaluation terms depending only on material (number of pieces
+ * of each type), cached by the material key of the position.
+ */
+struct MaterialEntry
+{
+    const endgame::EndgameBase* endgame;
+    Value weight;
+};
+
+using MaterialHashMap = HashMap<uint64_t, MaterialEntry, 8192>;
+
+/**
+ * @brief Cache of static evaluations indexed by zobrist hash.
+ * Every entry is a single word (upper half of the key and the value),
+ * so it can't be read half written and needs no locking.
+ */
+class EvalCache
+{
+  public:
+    static constexpr std::size_t DEFAULT_SIZE_MB = 1;
+
+    struct Stats
+    {
+        uint64_t probes = 0;
+        uint64_t hits = 0;
+    };
+
+    /**
+     * @brief Resizes cache to at most size_mb megabytes (0 disables it).
+     */
+    void resize(std::size_t size_mb);
+
+    void clear();
+
+    bool probe(uint64_t key, Value& value)
+    {
+        if (_entries.empty()) return false;
+
+        ++_stats.probes;
+        const uint64_t entry = _entries[key & _mask];
+        if ((entry & KEY_MASK) != (key & KEY_MASK)) return false;
+
+        ++_stats.hits;
+        value = static_cast<int32_t>(static_cast<uint32_t>(entry));
+        return true;
+    }
+
+    void store(uint64_t key, Value value)
+    {
+        if (_entries.empty()) return;
+        _entries[key & _mask] =
+            (key & KEY_MASK) | static_cast<uint32_t>(static_cast<int32_t>(value));
+    }
+
+    void prefetch(uint64_t key) const
+    {
+        if (!_entries.empty()) __builtin_prefetch(&_entries[key & _mask]);
+    }
+
+    std::size_t size_mb() const
+    {
+        return _entries.size() * sizeof(uint64_t) / (1024 * 1024);
+    }
+
+    const Stats& stats() const { return _stats; }
+
+  private:
+    static constexpr uint64_t KEY_MASK = 0xFFFFFFFF00000000ULL;
+
+    std::vector<uint64_t> _entries;
+    uint64_t _mask = 0;
+    Stats _stats;
+};
+
 class PositionScorer
 {
   public:
     PositionScorer();
 
+    /**
+     * @brief Returns static evaluation of position from the side
+     * to move point of view, cached in the eval cache.
+     */
     Value score(const Position& position);
 
-    void print_stats();
+    /**
+     * @brief Prefetches eval cache and pawn hash entries of the position,
+     * call it early when the position is going to be scored.
+     */
+    void prefetch(const Position& position) const
+    {
+        _eval_cache.prefetch(position.hash());
+        _pawn_hash_table.prefetch(position.pawn_hash());
+        _material_hash_table.prefetch(position.material_hash());
+    }
+
+    EvalCache& eval_cache() { return _eval_cache; }
+    const EvalCache& eval_cache() const { return _eval_cache; }
+
+    /**
+     * @brief Prints terms of the last evaluation of position.
+     */
+    void print_stats(const Position& position);
 
     void clear();
 
   private:
+    Value evaluate(const Position& position);
+
+    const MaterialEntry& probe_material(const Position& position);
+
     template <Color side>
     void setup(const Position& position);
 
@@ -64,7 +173,9 @@ class PositionScorer
     template <Color side>
     Bitboard get_real_possible_moves(const Position& position, Square sq, Bitboard moves);
 
+    EvalCache _eval_cache;
     PawnHashMap _pawn_hash_table;
+    MaterialHashMap _material_hash_table;
     Value _weight;
 
     Bitboard _attacked_by_bb[COLOR_NUM][PIECE_KIND_NUM];
@@ -5,6 +5,7 @@
 #include "movegen.h"
 #include "score.h"
 #include "search_utils.h"
+#include "tablebase.h"
 #include "time_manager.h"
 #include "transposition_table.h"
 #include "types.h"
@@ -108,12 +109,17 @@ Value compute_search_delta(Move* previous_best_moves, Depth current_depth,
 }
 
 Search::Search(const Position& position, const Limits& limits,
-               PositionScorer& scorer, tt::TTable& ttable)
+               std::vector<PositionScorer>& scorers, tt::TTable& ttable)
     : _position(position),
-      _scorer(scorer),
+      _scorers(scorers),
+      _scorer(scorers[0]),
       limits(limits),
+      _thread_id(0),
+      _helpers(),
+      _helper_threads(),
       check_limits_counter(4096),
-      stop_search(false),
+      _stop_flag(false),
+      stop_search(_stop_flag),
       _search_time(0),
       _search_depth(0),
       _current_depth(0),
@@ -123,10 +129,14 @@ Search::Search(const Position& position, const Limits& limits,
       _root_moves(),
       _ttable(ttable),
       _stack_info(),
+      _move_stack(),
       _history_score(),
-      _move_orderer(_ttable, _history_score),
-      _counter_move_table()
+      _counter_move_table(),
+      _counter_moves()
 {
+    // network could have changed since the position was set up
+    _position.refresh_accumulator();
+
     if (limits.searchmovesnum > 0)
     {
         const Move* begin = limits.searchmoves;
@@ -135,7 +145,7 @@ Search::Search(const Position& position, const Limits& limits,
     }
     else
     {
-        Move* begin = MOVE_LIST[0];
+        Move* begin = _move_stack[0].data();
         Move* end = generate_moves(_position, _position.color(), begin);
         _root_moves.insert(_root_moves.end(), begin, end);
     }
@@ -170,6 +180,33 @@ Search::Search(const Position& position, const Limits& limits,
     if (_max_nodes_searched == 0) _max_nodes_searched = MAX_NODE_COUNT;
 }
 
+Search::Search(Search& main, int thread_id)
+    : _position(main._position),
+      _scorers(main._scorers),
+      _scorer(main._scorers[thread_id]),
+      limits(main.limits),
+      _thread_id(thread_id),
+      _helpers(),
+      _helper_threads(),
+      check_limits_counter(4096),
+      _stop_flag(false),
+      stop_search(main._stop_flag),
+      _search_time(main._search_time),
+      _search_depth(main._search_depth),
+      _current_depth(0),
+      _max_nodes_searched(main._max_nodes_searched),
+      _best_move(NO_MOVE),
+      _start_time(main._start_time),
+      _root_moves(main._root_moves),
+      _ttable(main._ttable),
+      _stack_info(),
+      _move_stack(),
+      _history_score(),
+      _counter_move_table(),
+      _counter_moves()
+{
+}
+
 void Search::stop()
 {
     stop_search = true;
@@ -186,14 +223,63 @@ void Search::go()
     {
         _search_time = 500;
     }
+
+    start_helpers();
     iter_search();
+    stop_helpers();
+
+    tt::TTable::Stats tt_stats = _tt_stats;
+    for (const std::unique_ptr<Search>& helper : _helpers)
+        tt_stats += helper->_tt_stats;
+    _ttable.add_stats(tt_stats);
+    sync_cout << "info string tt " << tt_stats << " hashfull " << _ttable.hashfull() << sync_endl;
 
     ASSERT(_best_move != NO_MOVE);
     sync_cout << "bestmove " << _position.uci(_best_move) << sync_endl;
 }
 
+void Search::start_helpers()
+{
+    const int num_threads = static_cast<int>(_scorers.size());
+    for (int thread_id = 1; thread_id < num_threads; ++thread_id)
+    {
+        Search* helper = new Search(*this, thread_id);
+        _helpers.push_back(std::unique_ptr<Search>(helper));
+        _helper_threads.emplace_back([helper]() {
+            helper->init_search();
+            helper->iter_search();
+        });
+    }
+}
+
+void Search::stop_helpers()
+{
+    stop_search = true;
+    for (std::thread& thread : _helper_threads) thread.join();
+    _helper_threads.clear();
+}
+
+NodeCount Search::nodes_searched() const
+{
+    NodeCount nodes = _stats.nodes_searched;
+    for (const std::unique_ptr<Search>& helper : _helpers)
+        nodes += helper->_stats.nodes_searched;
+    return nodes;
+}
+
+uint64_t Search::tb_hits() const
+{
+    uint64_t hits = _stats.tb_hits;
+    for (const std::unique_ptr<Search>& helper : _helpers)
+        hits += helper->_stats.tb_hits;
+    return hits;
+}
+
 void Search::init_search()
 {
+    // counters add up over all iterations of one search
+    _stats.reset();
+
     for (Color c : {WHITE, BLACK})
         for (Square sq1 = SQ_A1; sq1 <= SQ_H8; ++sq1)
             for (Square sq2 = SQ_A1; sq2 <= SQ_H8; ++sq2)
@@ -203,6 +289,7 @@ void Search::init_search()
     {
         for (Square sq1 = SQ_A1; sq1 <= SQ_H8; ++sq1)
         {
+            _counter_moves[p1][sq1] = NO_MOVE;
             for (Piece p2 = W_PAWN; p2 <= B_KING; ++p2)
                 for (Square sq2 = SQ_A1; sq2 <= SQ_H8; ++sq2)
                     _counter_move_table[p1][sq1][p2][sq2] = 0;
@@ -212,18 +299,21 @@ void Search::init_search()
 
 void Search::print_info(Value result, Depth depth, int64_t elapsed, Info* info)
 {
+    const NodeCount nodes = nodes_searched();
     sync_cout << "info "
               << "depth " << depth << " "
               << "score " << score2str(result) << " "
-              << "nodes " << _stats.nodes_searched << " "
+              << "nodes " << nodes << " "
 #if LOG_LEVEL > 0
               << "pvnodes " << _stats.pv_nodes_searched << " "
               << "nonpvnodes " << _stats.non_pv_nodes_searched << " "
               << "qpvnodes " << _stats.quiescence_pv_nodes_searched << " "
               << "qnonpvnodes " << _stats.quiescence_nonpv_nodes_searched << " "
+              << "ttprobes " << _tt_stats.probes << " "
+              << "tthits " << _tt_stats.hits << " "
 #endif
-              << "nps " << (_stats.nodes_searched * 1000 / (elapsed + 1)) << " "
-              << "tbhits " << _stats.tb_hits << " "
+              << "nps " << (nodes * 1000 / (elapsed + 1)) << " "
+              << "tbhits " << tb_hits() << " "
               << "hashfull " << _ttable.hashfull() << " "
               << "time " << elapsed << " "
               << "pv ";
@@ -246,8 +336,7 @@ void Search::iter_search()
 
     MoveList pv_list;
     Value previous_score;
-    Move previous_moves[MAX_DEPTH + 1];
-    previous_moves[0] = NO_MOVE;
+    Move previous_moves[MAX_DEPTH + 1] = {NO_MOVE};
     Value min_bound = -VALUE_INFINITE;
     Value max_bound = VALUE_INFINITE;
 
@@ -256,13 +345,13 @@ void Search::iter_search()
     info->_current_move = NO_MOVE;
     info->_counter_move = &_counter_move_table[NO_PIECE][1];
 
-    _current_depth = 0;
+    // odd helper threads start one ply deeper, so that
+    // threads don't search the same depths at the same time
+    _current_depth = _thread_id % 2;
     while (!stop_search)
     {
         _current_depth++;
 
-        _stats = SearchStats{};
-
         Value result;
         Value delta = compute_search_delta(previous_moves, _current_depth,
                                            previous_score);
@@ -312,7 +401,8 @@ void Search::iter_search()
         {
             Info* realInfo = info + 1;
             ASSERT(realInfo->_pv_list_length > 0);
-            print_info(result, _current_depth, elapsed, realInfo);
+            if (_thread_id == 0)
+                print_info(result, _current_depth, elapsed, realInfo);
             _best_move = realInfo->_pv_list[0];
         }
         previous_moves[_current_depth] = _best_move;
@@ -350,16 +440,34 @@ Value Search::search(Position& position, Depth depth, Value alpha, Value beta,
     // without any move
     if (!ROOT_NODE && (position.is_repeated() || position.is_draw())) EXIT_SEARCH(VALUE_DRAW);
 
-    Move* begin = ROOT_NODE ? &(*_root_moves.begin()) : MOVE_LIST[info->_ply];
-    Move* end = ROOT_NODE ? &(*_root_moves.end())
-                          : generate_moves(position, position.color(), begin);
-    const int n_moves = end - begin;
+    // side to move can go back to an earlier position, so it gets
+    // at least a draw and lines worse than that can be pruned
+    if (!ROOT_NODE && alpha < VALUE_DRAW && position.has_upcoming_repetition())
+    {
+        alpha = VALUE_DRAW;
+        if (alpha >= beta) EXIT_SEARCH(alpha);
+    }
+
+    // Tablebases are probed only when material has just changed (after
+    // captures and pawn moves). Without distance to mate every won position
+    // looks the same, so inside the ending search is left to the endgame
+    // evaluation, which knows how to make progress.
+    if (!ROOT_NODE && position.half_moves() == 0 &&
+        popcount(position.pieces()) <= tablebase::max_pieces())
+    {
+        tablebase::WdlScore wdl;
+        if (tablebase::probe_wdl(position, wdl))
+        {
+            _stats.add_tb_hit();
+            EXIT_SEARCH(wdl == tablebase::kWIN    ? tb_win_in(info->_ply)
+                        : wdl == tablebase::kLOSS ? tb_lost_in(info->_ply)
+                                                  : VALUE_DRAW);
+        }
+    }
 
     bool is_in_check = position.is_in_check(position.color());
     if (is_in_check) depth++;
 
-    if (n_moves == 0) EXIT_SEARCH(is_in_check ? lost_in(0) : VALUE_DRAW);
-
     if (depth == 0 || info->_ply >= MAX_DEPTH)
     {
         LOG_DEBUG("[%d] START QUIESCENCE_SEARCH", info->_ply);
@@ -370,7 +478,7 @@ Value Search::search(Position& position, Depth depth, Value alpha, Value beta,
     }
 
     // update search stats
-    _stats.nodes_searched++;
+    _stats.add_node();
     (PV_NODE ? _stats.pv_nodes_searched : _stats.non_pv_nodes_searched)++;
 #if LOG_LEVEL >= 2
     uint64_t savedNumNodesSearched = _stats.nodes_searched;
@@ -378,41 +486,44 @@ Value Search::search(Position& position, Depth depth, Value alpha, Value beta,
 
     Value bestValue = -VALUE_INFINITE;
     bool found = false;
-    auto entryPtr = _ttable.probe(position.hash(), found);
+    auto ttEntry = _ttable.probe(position.hash(), found, &_tt_stats);
 
     // internal iterative deepening
     if (PV_NODE && !found && depth > 5)
     {
         search(position, depth - 2, alpha, beta, info);
-        entryPtr = _ttable.probe(position.hash(), found);
+        ttEntry = _ttable.probe(position.hash(), found, &_tt_stats);
     }
 
-    if (found && (entryPtr->value.depth >= depth) &&
-        (std::find(begin, end, entryPtr->value.move) != end))
+    const bool ttMoveLegal =
+        found && (ROOT_NODE ? std::find(_root_moves.begin(), _root_moves.end(),
+                                        ttEntry.move()) != _root_moves.end()
+                            : is_move_legal(position, ttEntry.move()));
+
+    if (found && (ttEntry.depth() >= depth) && ttMoveLegal)
     {
-        _stats.tb_hits++;
         LOG_DEBUG("[%d] CACHE HIT score=%ld depth=%d flag=%d move=%s",
-                  info->_ply, entryPtr->value.score, entryPtr->value.depth,
-                  static_cast<int>(entryPtr->value.flag),
-                  position.uci(entryPtr->value.move).c_str());
+                  info->_ply, ttEntry.score(), ttEntry.depth(),
+                  static_cast<int>(ttEntry.flag()),
+                  position.uci(ttEntry.move()).c_str());
 
         const bool allowCutoff =
-            !PV_NODE || _ttable.isCurrentEpoch(entryPtr->epoch);
+            !PV_NODE || _ttable.isCurrentEpoch(ttEntry.epoch());
 
         if (allowCutoff)
         {
-            switch (entryPtr->value.flag)
+            switch (ttEntry.flag())
             {
             case tt::Flag::kEXACT:
-                set_new_pv_list(info, entryPtr->value.move);
+                set_new_pv_list(info, ttEntry.move());
                 LOG_DEBUG("[%d] NODES SEARCHED %lu", info->_ply, _stats.nodes_searched - savedNumNodesSearched);
-                EXIT_SEARCH(Value(entryPtr->value.score));
+                EXIT_SEARCH(Value(ttEntry.score()));
             case tt::Flag::kLOWER_BOUND:
-                bestValue = entryPtr->value.score;
-                alpha = std::max(alpha, entryPtr->value.score);
+                bestValue = ttEntry.score();
+                alpha = std::max(alpha, ttEntry.score());
                 break;
             case tt::Flag::kUPPER_BOUND:
-                beta = std::min(beta, entryPtr->value.score);
+                beta = std::min(beta, ttEntry.score());
                 break;
             }
         }
@@ -420,7 +531,7 @@ Value Search::search(Position& position, Depth depth, Value alpha, Value beta,
         if (alpha >= beta)
         {
             LOG_DEBUG("[%d] NODES SEARCHED %lu", info->_ply, _stats.nodes_searched - savedNumNodesSearched);
-            EXIT_SEARCH(Value(entryPtr->value.score));
+            EXIT_SEARCH(Value(ttEntry.score()));
         }
     }
 
@@ -428,9 +539,9 @@ Value Search::search(Position& position, Depth depth, Value alpha, Value beta,
     {
         info->_static_eval = VALUE_NONE;
     }
-    else if (found && entryPtr->value.flag == tt::Flag::kEXACT)
+    else if (found && ttEntry.eval() != VALUE_NONE)
     {
-        info->_static_eval = entryPtr->value.score;
+        info->_static_eval = ttEntry.eval();
     }
     else
     {
@@ -451,13 +562,14 @@ Value Search::search(Position& position, Depth depth, Value alpha, Value beta,
 
         LOG_DEBUG("[%d] DO MOVE nullmove alpha=%ld beta=%ld", info->_ply, alpha,
                   beta);
-        MoveInfo moveinfo = position.do_null_move();
+        position.do_null_move();
+        _ttable.prefetch(position.hash());
         info->_current_move = NO_MOVE;  // this means that this was a null move
         info->_counter_move = &_counter_move_table[NO_PIECE][0];  // trash
         Value result =
             -search(position, reducedDepth, -beta, -beta + 1, info + 1);
         LOG_DEBUG("[%d] UNDO MOVE nullmove", info->_ply);
-        position.undo_null_move(moveinfo);
+        position.undo_null_move();
 
         if (result >= beta && depth < 14)
         {
@@ -493,13 +605,31 @@ Value Search::search(Position& position, Depth depth, Value alpha, Value beta,
         LOG_DEBUG("[%d] FUTILITY PRUNING", info->_ply);
     }
 
+    const Move ttMove = info->_pv_list_length > 0 ? info->_pv_list[0]
+                        : ttMoveLegal                ? ttEntry.move()
+                                                     : NO_MOVE;
+    const Move previousMove = (info - 1)->_current_move;
+    const Move counterMove =
+        previousMove != NO_MOVE
+            ? _counter_moves[position.piece_at(to(previousMove))][to(previousMove)]
+            : NO_MOVE;
+
+    MovePicker picker =
+        ROOT_NODE ? MovePicker(position, ttMove, info, _history_score,
+                               _root_moves.data(),
+                               _root_moves.data() + _root_moves.size())
+                  : MovePicker(position, ttMove, info, _history_score,
+                               counterMove, _move_stack[info->_ply].data());
+
     Move best_move = NO_MOVE;
-    _move_orderer.order_moves(position, begin, end, info);
+    Move first_move = NO_MOVE;
+    int move_count = 0;
 
-    for (int move_count = 0; move_count < n_moves; ++move_count)
+    for (Move move = picker.next_move(); move != NO_MOVE;
+         move = picker.next_move(), ++move_count)
     {
-        const Move move = begin[move_count];
         const bool moveIsQuiet = position.move_is_quiet(move);
+        if (first_move == NO_MOVE) first_move = move;
 
         if (doFutilityPruning && moveIsQuiet
                 && !position.move_gives_check(move))
@@ -509,13 +639,15 @@ Value Search::search(Position& position, Depth depth, Value alpha, Value beta,
 
         LOG_DEBUG("[%d] DO MOVE %s alpha=%ld beta=%ld", info->_ply,
                   position.uci(move).c_str(), alpha, beta);
-        const MoveInfo moveinfo = position.do_move(move);
+        position.do_move(move);
+        _ttable.prefetch(position.hash());
+        _scorer.prefetch(position);
 
         info->_current_move = move;
         info->_counter_move =
             &_counter_move_table[position.piece_at(from(move))][to(move)];
 
-        const PieceKind capturedPiece = captured_piece(moveinfo);
+        const PieceKind capturedPiece = make_piece_kind(position.captured_piece());
         const PieceKind promotedPiece = promotion(move);
 
         Value result = VALUE_NONE;
@@ -556,7 +688,7 @@ Value Search::search(Position& position, Depth depth, Value alpha, Value beta,
             result = -search(position, depth - 1, -beta, -alpha, info + 1);
         }
 
-        position.undo_move(move, moveinfo);
+        position.undo_move(move);
         LOG_DEBUG("[%d] UNDO MOVE %s", info->_ply,
                   position.uci(move).c_str());
 
@@ -582,11 +714,14 @@ Value Search::search(Position& position, Depth depth, Value alpha, Value beta,
                     {
                         update_move_scores(position, move, info, _history_score,
                                            depth);
+                        if (previousMove != NO_MOVE)
+                            _counter_moves[position.piece_at(to(previousMove))]
+                                          [to(previousMove)] = move;
                     }
 
                     tt::TTEntry entry(result, depth, tt::Flag::kLOWER_BOUND,
-                                      move);
-                    _ttable.insert(position.hash(), entry);
+                                      move, info->_static_eval);
+                    _ttable.insert(position.hash(), entry, &_tt_stats);
 
 #if LOG_LEVEL > 1
                     {
@@ -611,16 +746,18 @@ Value Search::search(Position& position, Depth depth, Value alpha, Value beta,
         }
     }
 
+    if (move_count == 0) EXIT_SEARCH(is_in_check ? lost_in(0) : VALUE_DRAW);
+
     if (best_move == NO_MOVE)
     {
-        best_move = begin[0];
+        best_move = first_move;
         set_new_pv_list(info, best_move);
     }
     else
     {
         tt::Flag flag = PV_NODE ? tt::Flag::kEXACT : tt::Flag::kUPPER_BOUND;
-        tt::TTEntry entry(bestValue, depth, flag, best_move);
-        _ttable.insert(position.hash(), entry);
+        tt::TTEntry entry(bestValue, depth, flag, best_move, info->_static_eval);
+        _ttable.insert(position.hash(), entry, &_tt_stats);
 
         LOG_DEBUG("[%d] BEST MOVE %s", info->_ply,
                   position.uci(best_move).c_str());
@@ -671,7 +808,7 @@ Value Search::quiescence_search(Position& position, Depth depth, Value alpha,
     if (position.is_draw()) EXIT_QSEARCH(VALUE_DRAW);
 
     // update search stats
-    _stats.nodes_searched++;
+    _stats.add_node();
     (PV_NODE ? _stats.quiescence_pv_nodes_searched : _stats.quiescence_nonpv_nodes_searched)++;
 #if LOG_LEVEL >= 2
     uint64_t savedNumNodesSearched = _stats.nodes_searched;
@@ -692,29 +829,25 @@ Value Search::quiescence_search(Position& position, Depth depth, Value alpha,
         if (PV_NODE && standpat > alpha) alpha = standpat;
     }
 
-    Move* begin = MOVE_LIST[info->_ply];
-    Move* end = generate_moves(position, position.color(), begin);
-    const int n_moves = end - begin;
-
-    if (n_moves == 0) EXIT_QSEARCH(is_in_check ? lost_in(0) : VALUE_DRAW);
-
-    _move_orderer.order_moves(position, begin, end, info);
-
-    for (int move_count = 0; move_count < n_moves; ++move_count)
+    // only captures and promotions are searched, unless in check
+    bool found = false;
+    const auto ttEntry = _ttable.probe(position.hash(), found);
+    MovePicker picker(position, found ? ttEntry.move() : NO_MOVE, info,
+                      _history_score, _move_stack[info->_ply].data(),
+                      is_in_check);
+    int move_count = 0;
+
+    for (Move move = picker.next_move(); move != NO_MOVE;
+         move = picker.next_move(), ++move_count)
     {
-        Move move = begin[move_count];
         info->_current_move = move;
         info->_counter_move =
             &_counter_move_table[position.piece_at(from(move))][to(move)];
 
-        if (!is_in_check && position.move_is_quiet(move))
-        {
-            continue;
-        }
-
         LOG_DEBUG("[%d] DO MOVE %s alpha=%ld beta=%ld", info->_ply,
                   position.uci(move).c_str(), alpha, beta);
-        MoveInfo moveinfo = position.do_move(move);
+        position.do_move(move);
+        _scorer.prefetch(position);
 
         Value result = -quiescence_search(position, depth - 1, -(alpha + 1),
                                           -alpha, info + 1);
@@ -724,7 +857,7 @@ Value Search::quiescence_search(Position& position, Depth depth, Value alpha,
                                         info + 1);
         }
 
-        position.undo_move(move, moveinfo);
+        position.undo_move(move);
         LOG_DEBUG("[%d] UNDO MOVE %s", info->_ply,
                   position.uci(move).c_str());
 
@@ -749,18 +882,23 @@ Value Search::quiescence_search(Position& position, Depth depth, Value alpha,
         }
     }
 
+    if (is_in_check && move_count == 0) EXIT_QSEARCH(lost_in(0));
+
     LOG_DEBUG("[%d] NODES SEARCHED %lu", info->_ply, _stats.nodes_searched - savedNumNodesSearched);
     EXIT_QSEARCH(bestValue);
 }
 
 bool Search::check_limits()
 {
+    // only main thread checks limits, helpers wait for stop_search
+    if (_thread_id != 0) return false;
+
     check_limits_counter--;
     if (check_limits_counter > 0) return false;
 
     check_limits_counter = 40960;
 
-    if (_stats.nodes_searched >= _max_nodes_searched)
+    if (nodes_searched() >= _max_nodes_searched)
     {
         stop_search = true;
         return true;
@@ -1,15 +1,19 @@
 #ifndef CHESS_ENGINE_SEARCH_H_
 #define CHESS_ENGINE_SEARCH_H_
 
-#include "move_orderer.h"
+#include "move_picker.h"
 #include "position.h"
 #include "score.h"
 #include "time_manager.h"
 #include "transposition_table.h"
 #include "types.h"
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
 
 namespace engine
 {
@@ -25,20 +29,44 @@ constexpr Duration INFINITE_DURATION = 1LL << 32;
 
 struct SearchStats
 {
-    SearchStats()
-        : nodes_searched(0)
-        , pv_nodes_searched(0)
-        , non_pv_nodes_searched(0)
-        , quiescence_pv_nodes_searched(0)
-        , quiescence_nonpv_nodes_searched(0)
-        , tb_hits(0)
+    SearchStats() { reset(); }
+
+    void reset()
     {
+        nodes_searched = 0;
+        pv_nodes_searched = 0;
+        non_pv_nodes_searched = 0;
+        quiescence_pv_nodes_searched = 0;
+        quiescence_nonpv_nodes_searched = 0;
+        tb_hits = 0;
+    }
+
+    /**
+     * @brief Increments node counter.
+     * Only the owning thread writes the counter, other threads
+     * are only allowed to read it (e.g. to report total nodes).
+     */
+    void add_node()
+    {
+        nodes_searched.store(
+            nodes_searched.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Increments tablebase hits counter,
+     * same rules as for add_node apply.
+     */
+    void add_tb_hit()
+    {
+        tb_hits.store(tb_hits.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
     }
 
     /**
      * @brief Total number of nodes searched.
      */
-    NodeCount nodes_searched;
+    std::atomic<NodeCount> nodes_searched;
     /**
      * @brief Number of PV nodes searched.
      */
@@ -56,26 +84,51 @@ struct SearchStats
      */
     NodeCount quiescence_nonpv_nodes_searched;
     /**
-     * @brief Number of ttable hits.
+     * @brief Number of successful tablebase probes.
      */
-    uint64_t tb_hits;
+    std::atomic<uint64_t> tb_hits;
 };
 
 class Search
 {
   public:
+    /**
+     * @brief Creates new search.
+     * Search runs one thread per scorer (Lazy SMP),
+     * all threads share the same transposition table.
+     */
     Search(const Position& position, const Limits& limits,
-           PositionScorer& scorer, tt::TTable& ttable);
+           std::vector<PositionScorer>& scorers, tt::TTable& ttable);
 
     void go();
 
     void stop();
 
   private:
+    /**
+     * @brief Creates helper search for thread thread_id.
+     * Helper shares stop flag and transposition table with main search.
+     */
+    Search(Search& main, int thread_id);
+
     void init_search();
 
     void iter_search();
 
+    void start_helpers();
+
+    void stop_helpers();
+
+    /**
+     * @brief Returns number of nodes searched by all threads.
+     */
+    NodeCount nodes_searched() const;
+
+    /**
+     * @brief Returns number of tablebase hits of all threads.
+     */
+    uint64_t tb_hits() const;
+
 
     Value search(Position& position, Depth depth, Value alpha, Value beta,
                  Info* info);
@@ -88,11 +141,18 @@ class Search
     bool check_limits();
 
     Position _position;
+    std::vector<PositionScorer>& _scorers;
     PositionScorer& _scorer;
     Limits limits;
 
+    int _thread_id;
+    std::vector<std::unique_ptr<Search>> _helpers;
+    std::vector<std::thread> _helper_threads;
+
     int64_t check_limits_counter;
-    bool stop_search;
+    std::atomic<bool> _stop_flag;
+    // points to _stop_flag of the main search
+    std::atomic<bool>& stop_search;
 
     Duration _search_time;
     Depth _search_depth;
@@ -106,11 +166,15 @@ class Search
 
     tt::TTable& _ttable;
     StackInfo _stack_info;
+    MoveStack _move_stack;
     HistoryScore _history_score;
-    MoveOrderer _move_orderer;
     Array2D<PieceHistory, PIECE_NUM, SQUARE_NUM> _counter_move_table;
+    // last quiet move which refuted move of [piece] to [square]
+    Array2D<Move, PIECE_NUM, SQUARE_NUM> _counter_moves;
 
     SearchStats _stats;
+    // counted over the whole search (not reset between iterations)
+    tt::TTable::Stats _tt_stats;
 };
 
 }  // namespace engine
@@ -0,0 +1,753 @@
+#include "tablebase.h"
+
+#include "bitboard.h"
+#include "bithacks.h"
+#include "move_bitboards.h"
+#include "value.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engine
+{
+namespace tablebase
+{
+namespace
+{
+constexpr char FILE_MAGIC[8] = {'C', 'P', 'P', 'T', 'B', 0, 0, 0};
+constexpr uint32_t FILE_VERSION = 1;
+constexpr const char* FILE_EXTENSION = ".cpptb";
+
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t pcv;
+    uint64_t entries;
+};
+
+// results are packed by 5 in a byte (3^5 < 256)
+constexpr int RESULTS_PER_BYTE = 5;
+constexpr uint32_t POW3[RESULTS_PER_BYTE] = {1, 3, 9, 27, 81};
+
+// order of non-king pieces in tables
+constexpr PieceKind TABLE_ORDER[] = {QUEEN, ROOK, BISHOP, KNIGHT, PAWN};
+
+/**
+ * @brief Squares of table pieces (in the table order) and side to move.
+ */
+struct Placement
+{
+    Square squares[MAX_PIECES];
+    Color side;
+};
+
+struct Table
+{
+    Table(PieceCountVector pcv);
+    ~Table();
+
+    Table(const Table&) = delete;
+    Table& operator=(const Table&) = delete;
+
+    WdlScore get(std::size_t index) const
+    {
+        const uint32_t packed = data[index / RESULTS_PER_BYTE];
+        return WdlScore(static_cast<int32_t>(packed / POW3[index % RESULTS_PER_BYTE] % 3) - 1);
+    }
+
+    std::string name() const;
+
+    PieceCountVector pcv;
+    // kings first, then white and black pieces in TABLE_ORDER
+    Piece pieces[MAX_PIECES];
+    int num_pieces;
+    bool has_pawns;
+    // number of white king squares left after symmetry reduction
+    std::size_t regions;
+    std::size_t size;
+
+    const uint8_t* data = nullptr;
+    std::vector<uint8_t> storage;
+    void* mapping = nullptr;
+    std::size_t mapping_size = 0;
+};
+
+std::unordered_map<PieceCountVector, std::unique_ptr<Table>> tables;
+int loaded_max_pieces = 0;
+
+int piece_count(PieceCountVector pcv, Piece piece)
+{
+    return static_cast<int>((pcv >> (4 * piece)) & 0xF);
+}
+
+Table::Table(PieceCountVector pcv) : pcv(pcv), pieces(), num_pieces(2), has_pawns(false)
+{
+    pieces[0] = W_KING;
+    pieces[1] = B_KING;
+    for (Color side : {WHITE, BLACK})
+    {
+        for (PieceKind kind : TABLE_ORDER)
+        {
+            const Piece piece = make_piece(side, kind);
+            for (int i = 0; i < piece_count(pcv, piece); ++i)
+                pieces[num_pieces++] = piece;
+            has_pawns |= kind == PAWN && piece_count(pcv, piece) > 0;
+        }
+    }
+
+    // white king is kept on files A-D (and ranks 1-4 without pawns)
+    regions = has_pawns ? 32 : 16;
+    size = 2 * regions;
+    for (int i = 1; i < num_pieces; ++i) size *= SQUARE_NUM;
+}
+
+Table::~Table()
+{
+#if defined(__linux__)
+    if (mapping) munmap(mapping, mapping_size);
+#endif
+}
+
+std::string Table::name() const
+{
+    const std::string piece_to_char = " PNBRQKPNBRQK";
+    std::string name = "K";
+    for (int i = 2; i < num_pieces; ++i)
+    {
+        if (get_color(pieces[i]) == BLACK && get_color(pieces[i - 1]) != BLACK)
+            name += "vK";
+        name += piece_to_char[pieces[i]];
+    }
+    if (get_color(pieces[num_pieces - 1]) == WHITE) name += "vK";
+    return name;
+}
+
+Bitboard attacks(Piece piece, Square square, Bitboard occupied)
+{
+    switch (get_piece_kind(piece))
+    {
+    case PAWN: return pawn_attacks(square_bb(square), get_color(piece));
+    case KNIGHT: return KNIGHT_MASK[square];
+    case BISHOP: return slider_attack<BISHOP>(square, occupied);
+    case ROOK: return slider_attack<ROOK>(square, occupied);
+    case QUEEN: return slider_attack<QUEEN>(square, occupied);
+    case KING: return KING_MASK[square];
+    default: return 0ULL;
+    }
+}
+
+bool is_attacked(const Piece* pieces, const Square* squares, int n,
+                 Square target, Color by)
+{
+    Bitboard occupied = 0ULL;
+    for (int i = 0; i < n; ++i) occupied |= square_bb(squares[i]);
+
+    for (int i = 0; i < n; ++i)
+    {
+        if (get_color(pieces[i]) != by) continue;
+
+        // skip slider lookup if the piece isn't on any line through the target
+        const PieceKind kind = get_piece_kind(pieces[i]);
+        if (kind >= BISHOP && kind <= QUEEN && !FULL_LINES[squares[i]][target]) continue;
+
+        if (attacks(pieces[i], squares[i], occupied) & square_bb(target)) return true;
+    }
+    return false;
+}
+
+Square king_square(const Piece* pieces, const Square* squares, int n, Color side)
+{
+    for (int i = 0; i < n; ++i)
+        if (pieces[i] == make_piece(side, KING)) return squares[i];
+    return NO_SQUARE;
+}
+
+bool is_valid(const Table& table, const Placement& placement)
+{
+    Bitboard occupied = 0ULL;
+    for (int i = 0; i < table.num_pieces; ++i)
+    {
+        const Square square = placement.squares[i];
+        if (occupied & square_bb(square)) return false;
+        if (get_piece_kind(table.pieces[i]) == PAWN &&
+            (rank(square) == RANK_1 || rank(square) == RANK_8))
+            return false;
+        occupied |= square_bb(square);
+    }
+
+    if (distance(placement.squares[0], placement.squares[1]) <= 1) return false;
+
+    // side which is not to move can't be in check
+    const Color them = !placement.side;
+    return !is_attacked(table.pieces, placement.squares, table.num_pieces,
+                        placement.squares[them == WHITE ? 0 : 1], placement.side);
+}
+
+std::size_t encode(const Table& table, Placement placement)
+{
+    Square* squares = placement.squares;
+    if (file(squares[0]) > FILE_D)
+        for (int i = 0; i < table.num_pieces; ++i) squares[i] = flip_horizontally(squares[i]);
+    if (!table.has_pawns && rank(squares[0]) > RANK_4)
+        for (int i = 0; i < table.num_pieces; ++i) squares[i] = flip_vertically(squares[i]);
+
+    std::size_t index = placement.side * table.regions +
+                        static_cast<std::size_t>(rank(squares[0]) * 4 + file(squares[0]));
+    for (int i = 1; i < table.num_pieces; ++i) index = index * SQUARE_NUM + squares[i];
+    return index;
+}
+
+Placement decode(const Table& table, std::size_t index)
+{
+    Placement placement;
+    for (int i = table.num_pieces - 1; i > 0; --i)
+    {
+        placement.squares[i] = Square(index % SQUARE_NUM);
+        index /= SQUARE_NUM;
+    }
+    const std::size_t region = index % table.regions;
+    placement.squares[0] = make_square(Rank(region / 4), File(region % 4));
+    placement.side = Color(index / table.regions);
+    return placement;
+}
+
+/**
+ * @brief Looks up position given by list of pieces (in any order).
+ * Material with only kings is a draw.
+ */
+bool probe(const Piece* pieces, const Square* squares, int n, Color side,
+           WdlScore& score)
+{
+    PieceCountVector pcv = 0;
+    for (int i = 0; i < n; ++i)
+        if (get_piece_kind(pieces[i]) != KING) pcv += PieceCountVector(1) << (4 * pieces[i]);
+
+    if (pcv == 0)
+    {
+        score = kDRAW;
+        return true;
+    }
+
+    // tables are stored only with the stronger side as white,
+    // otherwise colors are swapped
+    bool flip = false;
+    auto it = tables.find(pcv);
+    if (it == tables.end())
+    {
+        it = tables.find(flip_pcv(pcv));
+        if (it == tables.end()) return false;
+        flip = true;
+    }
+    const Table& table = *it->second;
+
+    Placement placement;
+    placement.side = flip ? !side : side;
+    bool used[MAX_PIECES] = {};
+    for (int i = 0; i < table.num_pieces; ++i)
+    {
+        const Piece piece = flip ? make_piece(!get_color(table.pieces[i]),
+                                              get_piece_kind(table.pieces[i]))
+                                 : table.pieces[i];
+        for (int j = 0; j < n; ++j)
+        {
+            if (!used[j] && pieces[j] == piece)
+            {
+                used[j] = true;
+                placement.squares[i] = flip ? flip_vertically(squares[j]) : squares[j];
+                break;
+            }
+        }
+    }
+
+    score = table.get(encode(table, placement));
+    return true;
+}
+
+/**
+ * @brief Calls function(pieces, squares, n, in_table) for positions
+ * after every legal move. Moves which change material (captures and
+ * promotions) lead to positions from other tables.
+ */
+template <typename Function>
+void for_each_move(const Table& table, const Placement& placement, Function function)
+{
+    const int n = table.num_pieces;
+    const Color us = placement.side;
+
+    Bitboard occupied = 0ULL;
+    Bitboard by_color[COLOR_NUM] = {0ULL, 0ULL};
+    for (int i = 0; i < n; ++i)
+    {
+        occupied |= square_bb(placement.squares[i]);
+        by_color[get_color(table.pieces[i])] |= square_bb(placement.squares[i]);
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        const Piece piece = table.pieces[i];
+        if (get_color(piece) != us) continue;
+
+        const Square from = placement.squares[i];
+        const bool is_pawn = get_piece_kind(piece) == PAWN;
+        Bitboard targets;
+        if (is_pawn)
+        {
+            const Square push = Square(us == WHITE ? from + 8 : from - 8);
+            targets = pawn_attacks(square_bb(from), us) & by_color[!us];
+            if (!(occupied & square_bb(push)))
+            {
+                targets |= square_bb(push);
+                const Square double_push = Square(us == WHITE ? push + 8 : push - 8);
+                if (rank(normalize(from, us)) == RANK_2 && !(occupied & square_bb(double_push)))
+                    targets |= square_bb(double_push);
+            }
+        }
+        else
+        {
+            targets = attacks(piece, from, occupied) & ~by_color[us];
+        }
+
+        while (targets)
+        {
+            const Square to = Square(pop_lsb(&targets));
+
+            Piece pieces[MAX_PIECES];
+            Square squares[MAX_PIECES];
+            int m = 0;
+            bool capture = false;
+            int moved = 0;
+            for (int j = 0; j < n; ++j)
+            {
+                if (j != i && placement.squares[j] == to)
+                {
+                    capture = true;
+                    continue;
+                }
+                if (j == i) moved = m;
+                pieces[m] = table.pieces[j];
+                squares[m++] = j == i ? to : placement.squares[j];
+            }
+
+            if (is_attacked(pieces, squares, m, king_square(pieces, squares, m, us), !us))
+                continue;
+
+            if (is_pawn && (rank(to) == RANK_1 || rank(to) == RANK_8))
+            {
+                for (PieceKind kind : {QUEEN, ROOK, BISHOP, KNIGHT})
+                {
+                    pieces[moved] = make_piece(us, kind);
+                    function(pieces, squares, m, false);
+                }
+            }
+            else
+            {
+                function(pieces, squares, m, !capture);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Calls function(placement) for every position from which
+ * a move not changing material leads to the given position.
+ * Positions aren't checked for validity (the side not to move can
+ * be in check), solve() already marked invalid ones.
+ */
+template <typename Function>
+void for_each_unmove(const Table& table, const Placement& placement, Function function)
+{
+    const int n = table.num_pieces;
+    const Color them = !placement.side;
+
+    Bitboard occupied = 0ULL;
+    for (int i = 0; i < n; ++i) occupied |= square_bb(placement.squares[i]);
+
+    for (int i = 0; i < n; ++i)
+    {
+        const Piece piece = table.pieces[i];
+        if (get_color(piece) != them) continue;
+
+        const Square to = placement.squares[i];
+        Bitboard origins = 0ULL;
+        if (get_piece_kind(piece) == PAWN)
+        {
+            const Rank relative_rank = rank(normalize(to, them));
+            const Square back = Square(them == WHITE ? to - 8 : to + 8);
+            if (relative_rank >= RANK_3 && !(occupied & square_bb(back)))
+            {
+                origins |= square_bb(back);
+                const Square double_back = Square(them == WHITE ? back - 8 : back + 8);
+                if (relative_rank == RANK_4 && !(occupied & square_bb(double_back)))
+                    origins |= square_bb(double_back);
+            }
+        }
+        else
+        {
+            origins = attacks(piece, to, occupied) & ~occupied;
+        }
+
+        while (origins)
+        {
+            Placement previous = placement;
+            previous.squares[i] = Square(pop_lsb(&origins));
+            previous.side = them;
+            function(previous);
+        }
+    }
+}
+
+enum State : uint8_t
+{
+    kINVALID,
+    kUNKNOWN,
+    kLOST,
+    kDRAWN,
+    kWON
+};
+
+// counter of moves to undecided positions, highest bit marks a drawing move
+constexpr uint8_t HAS_DRAW = 0x80;
+
+/**
+ * @brief Solves table by retrograde analysis, tables reachable
+ * by captures and promotions have to be already loaded.
+ */
+void solve(Table& table)
+{
+    std::vector<uint8_t> states(table.size, kINVALID);
+    std::vector<uint8_t> counters(table.size, 0);
+    std::vector<uint32_t> queue;
+
+    for (std::size_t index = 0; index < table.size; ++index)
+    {
+        const Placement placement = decode(table, index);
+        if (!is_valid(table, placement)) continue;
+
+        bool won = false;
+        bool has_moves = false;
+        uint8_t counter = 0;
+        for_each_move(table, placement,
+                      [&](const Piece* pieces, const Square* squares, int n, bool in_table) {
+                          has_moves = true;
+                          if (in_table)
+                          {
+                              ++counter;
+                              return;
+                          }
+
+                          WdlScore score = kDRAW;
+                          probe(pieces, squares, n, !placement.side, score);
+                          won |= score == kLOSS;
+                          if (score == kDRAW) counter |= HAS_DRAW;
+                      });
+
+        if (!has_moves)
+        {
+            const Color us = placement.side;
+            const bool in_check = is_attacked(table.pieces, placement.squares, table.num_pieces,
+                                              placement.squares[us == WHITE ? 0 : 1], !us);
+            states[index] = in_check ? kLOST : kDRAWN;
+        }
+        else if (won)
+            states[index] = kWON;
+        else if ((counter & ~HAS_DRAW) == 0)
+            states[index] = counter & HAS_DRAW ? kDRAWN : kLOST;
+        else
+            states[index] = kUNKNOWN;
+
+        counters[index] = counter;
+        if (states[index] == kWON || states[index] == kLOST)
+            queue.push_back(static_cast<uint32_t>(index));
+    }
+
+    for (std::size_t next = 0; next < queue.size(); ++next)
+    {
+        const std::size_t index = queue[next];
+        const bool lost = states[index] == kLOST;
+
+        for_each_unmove(table, decode(table, index), [&](const Placement& previous) {
+            const std::size_t previous_index = encode(table, previous);
+            if (states[previous_index] != kUNKNOWN) return;
+
+            if (lost)
+            {
+                states[previous_index] = kWON;
+                queue.push_back(static_cast<uint32_t>(previous_index));
+            }
+            else if ((--counters[previous_index] & ~HAS_DRAW) == 0)
+            {
+                if (counters[previous_index] & HAS_DRAW)
+                    states[previous_index] = kDRAWN;
+                else
+                {
+                    states[previous_index] = kLOST;
+                    queue.push_back(static_cast<uint32_t>(previous_index));
+                }
+            }
+        });
+    }
+
+    table.storage.assign((table.size + RESULTS_PER_BYTE - 1) / RESULTS_PER_BYTE, 0);
+    for (std::size_t index = 0; index < table.size; ++index)
+    {
+        // invalid and undecided positions are stored as draws
+        const uint32_t result = states[index] == kWON ? 2 : states[index] == kLOST ? 0 : 1;
+        table.storage[index / RESULTS_PER_BYTE] +=
+            static_cast<uint8_t>(result * POW3[index % RESULTS_PER_BYTE]);
+    }
+    table.data = table.storage.data();
+}
+
+bool write(const Table& table, const std::string& path)
+{
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream) return false;
+
+    FileHeader header;
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.reserved = 0;
+    header.pcv = table.pcv;
+    header.entries = table.size;
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(table.storage.data()),
+                 static_cast<std::streamsize>(table.storage.size()));
+    return static_cast<bool>(stream);
+}
+
+std::unique_ptr<Table> map_table(const std::string& path)
+{
+#if defined(__linux__)
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 ||
+        static_cast<std::size_t>(file_stat.st_size) < sizeof(FileHeader))
+    {
+        close(fd);
+        return nullptr;
+    }
+    const std::size_t file_size = static_cast<std::size_t>(file_stat.st_size);
+
+    void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return nullptr;
+
+    FileHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+
+    std::unique_ptr<Table> table;
+    if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0 &&
+        header.version == FILE_VERSION && header.pcv != 0)
+        table = std::make_unique<Table>(header.pcv);
+
+    if (!table || table->num_pieces > MAX_PIECES || header.entries != table->size ||
+        file_size != sizeof(FileHeader) + (table->size + RESULTS_PER_BYTE - 1) / RESULTS_PER_BYTE)
+    {
+        munmap(mapping, file_size);
+        return nullptr;
+    }
+
+    table->mapping = mapping;
+    table->mapping_size = file_size;
+    table->data = static_cast<const uint8_t*>(mapping) + sizeof(FileHeader);
+    return table;
+#else
+    (void)path;
+    return nullptr;
+#endif
+}
+
+int material_value(PieceCountVector pcv, Color side)
+{
+    int value = 0;
+    for (PieceKind kind : TABLE_ORDER)
+        value += piece_count(pcv, make_piece(side, kind)) * static_cast<int>(PIECE_VALUE[kind].mg);
+    return value;
+}
+
+/**
+ * @brief Returns material with colors swapped if needed,
+ * so that the stronger side is white.
+ */
+PieceCountVector normalize(PieceCountVector pcv)
+{
+    const int white = material_value(pcv, WHITE);
+    const int black = material_value(pcv, BLACK);
+    return white > black || (white == black && pcv >= flip_pcv(pcv)) ? pcv : flip_pcv(pcv);
+}
+
+/**
+ * @brief Adds material and materials reachable from it
+ * by captures and promotions.
+ */
+void add_with_dependencies(PieceCountVector pcv, std::set<PieceCountVector>& materials)
+{
+    pcv = normalize(pcv);
+    if (!materials.insert(pcv).second) return;
+
+    for (Piece piece = W_PAWN; piece <= B_QUEEN; ++piece)
+    {
+        if (piece == W_KING || piece_count(pcv, piece) == 0) continue;
+
+        const PieceCountVector captured = pcv - (PieceCountVector(1) << (4 * piece));
+        add_with_dependencies(captured, materials);
+
+        if (get_piece_kind(piece) != PAWN) continue;
+        for (PieceKind kind : {KNIGHT, BISHOP, ROOK, QUEEN})
+        {
+            const Piece promoted = make_piece(get_color(piece), kind);
+            add_with_dependencies(captured + (PieceCountVector(1) << (4 * promoted)), materials);
+        }
+    }
+}
+
+/**
+ * @brief Lists materials of all tables with up to max_pieces pieces,
+ * in order in which they can be generated.
+ */
+std::vector<PieceCountVector> all_materials(int max_pieces)
+{
+    const std::vector<Piece> non_kings = {W_PAWN, W_KNIGHT, W_BISHOP, W_ROOK, W_QUEEN,
+                                          B_PAWN, B_KNIGHT, B_BISHOP, B_ROOK, B_QUEEN};
+
+    std::vector<PieceCountVector> materials = {0};
+    std::vector<PieceCountVector> last = {0};
+    for (int pieces = 3; pieces <= max_pieces; ++pieces)
+    {
+        std::vector<PieceCountVector> next;
+        for (PieceCountVector pcv : last)
+            for (Piece piece : non_kings)
+                next.push_back(pcv + (PieceCountVector(1) << (4 * piece)));
+        std::sort(next.begin(), next.end());
+        next.erase(std::unique(next.begin(), next.end()), next.end());
+        materials.insert(materials.end(), next.begin(), next.end());
+        last = next;
+    }
+
+    // keep only materials with stronger side as white
+    std::erase_if(materials, [](PieceCountVector pcv) {
+        return pcv == 0 || normalize(pcv) != pcv ||
+               pcv == create_pcv(1, 0, 0, 0, 0, 1, 0, 0, 0, 0);
+    });
+
+    // captures lead to tables with less pieces
+    // and promotions to tables with less pawns
+    auto order = [](PieceCountVector pcv) {
+        int pieces = 0;
+        for (Piece piece = W_PAWN; piece <= B_QUEEN; ++piece) pieces += piece_count(pcv, piece);
+        return std::make_pair(pieces, piece_count(pcv, W_PAWN) + piece_count(pcv, B_PAWN));
+    };
+    std::stable_sort(materials.begin(), materials.end(),
+                     [&order](PieceCountVector a, PieceCountVector b) { return order(a) < order(b); });
+    return materials;
+}
+
+}  // namespace
+
+int generate(const std::string& directory, int max_pieces, std::ostream& log)
+{
+    max_pieces = std::clamp(max_pieces, 3, MAX_PIECES);
+    return generate_with_dependencies(directory, all_materials(max_pieces), log);
+}
+
+int generate_with_dependencies(const std::string& directory,
+                               const std::vector<PieceCountVector>& materials, std::ostream& log)
+{
+    release();
+
+    std::set<PieceCountVector> needed;
+    for (PieceCountVector pcv : materials) add_with_dependencies(pcv, needed);
+
+    int count = 0;
+    for (PieceCountVector pcv : all_materials(MAX_PIECES))
+    {
+        if (!needed.count(pcv)) continue;
+
+        auto table = std::make_unique<Table>(pcv);
+        solve(*table);
+
+        const std::string path =
+            (std::filesystem::path(directory) / (table->name() + FILE_EXTENSION)).string();
+        if (!write(*table, path)) return -1;
+        log << "info string Generated " << path << std::endl;
+
+        loaded_max_pieces = std::max(loaded_max_pieces, table->num_pieces);
+        tables[pcv] = std::move(table);
+        ++count;
+    }
+
+    return count;
+}
+
+int init(const std::string& directory)
+{
+    release();
+
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.path().extension() != FILE_EXTENSION) continue;
+
+        std::unique_ptr<Table> table = map_table(entry.path().string());
+        if (!table) continue;
+
+        loaded_max_pieces = std::max(loaded_max_pieces, table->num_pieces);
+        tables[table->pcv] = std::move(table);
+    }
+
+    return static_cast<int>(tables.size());
+}
+
+void release()
+{
+    tables.clear();
+    loaded_max_pieces = 0;
+}
+
+int max_pieces()
+{
+    return loaded_max_pieces;
+}
+
+bool probe_wdl(const Position& position, WdlScore& score)
+{
+    if (popcount(position.pieces()) > loaded_max_pieces ||
+        position.castling_rights() != NO_CASTLING ||
+        position.enpassant_square() != NO_SQUARE)
+        return false;
+
+    Piece pieces[MAX_PIECES];
+    Square squares[MAX_PIECES];
+    int n = 0;
+    for (Piece piece = W_PAWN; piece <= B_KING; ++piece)
+    {
+        for (int i = 0; i < position.number_of_pieces(piece); ++i)
+        {
+            pieces[n] = piece;
+            squares[n++] = position.piece_position(piece, i);
+        }
+    }
+
+    return probe(pieces, squares, n, position.color(), score);
+}
+
+}  // namespace tablebase
+}  // namespace engine
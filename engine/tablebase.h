@@ -0,0 +1,76 @@
+#ifndef CHESS_ENGINE_TABLEBASE_H_
+#define CHESS_ENGINE_TABLEBASE_H_
+
+#include "position.h"
+#include "types.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+/**
+ * Win/draw/loss tablebases for endings with up to MAX_PIECES pieces
+ * (kings included).
+ *
+ * Tables are generated offline by retrograde analysis (gentb command),
+ * one file per material combination (e.g. KRvKP.cpptb), with the stronger
+ * side as white. Positions are indexed by side to move, white king square
+ * (reduced by board symmetries) and squares of the remaining pieces,
+ * results are packed by 5 in a byte. Files are memory mapped when loaded.
+ *
+ * Castling and en passant are not taken into account, so positions
+ * with castling rights or en passant square are never probed
+ * (and KPvKP, the only ending with en passant, is not generated).
+ */
+namespace tablebase
+{
+constexpr int MAX_PIECES = 4;
+
+enum WdlScore : int32_t
+{
+    kLOSS = -1,
+    kDRAW = 0,
+    kWIN = 1
+};
+
+/**
+ * @brief Generates all tables with up to max_pieces pieces into directory.
+ * Already generated tables have to be kept in memory (as they are needed
+ * to resolve captures and promotions), so all of them are loaded afterwards.
+ * Returns number of generated tables or -1 if a file couldn't be written.
+ */
+int generate(const std::string& directory, int max_pieces, std::ostream& log);
+
+/**
+ * @brief Generates tables of given materials (either side can be
+ * the stronger one) together with all smaller tables they depend on.
+ * Materials with more than MAX_PIECES pieces are skipped.
+ */
+int generate_with_dependencies(const std::string& directory,
+                               const std::vector<PieceCountVector>& materials, std::ostream& log);
+
+/**
+ * @brief Maps all tables found in directory (previously loaded
+ * tables are released), returns number of loaded tables.
+ */
+int init(const std::string& directory);
+
+void release();
+
+/**
+ * @brief Largest number of pieces of loaded tables (0 when there are none).
+ */
+int max_pieces();
+
+/**
+ * @brief Probes result of position from the side to move point of view.
+ * Returns false if there is no table for the position.
+ */
+bool probe_wdl(const Position& position, WdlScore& score);
+
+}  // namespace tablebase
+}  // namespace engine
+
+#endif  // CHESS_ENGINE_TABLEBASE_H_
@@ -0,0 +1,357 @@
+#include "transposition_table.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engine
+{
+namespace tt
+{
+namespace
+{
+constexpr Value EXACT_RANGE = 1 << 14;
+constexpr Value KNOWN_WIN_RANGE = 6144;
+constexpr Value TB_WIN_RANGE = 256;
+constexpr Value MATE_RANGE = 256;
+constexpr Value COARSE_STEP = 64;
+constexpr int16_t PACKED_NONE = INT16_MIN;
+
+static_assert(2 * MAX_DEPTH < MATE_RANGE);
+static_assert(2 * MAX_DEPTH < TB_WIN_RANGE);
+
+/**
+ * Absolute values are split into bands, values in each band are
+ * stored as multiples of its step above the beginning of the band.
+ * Regular evaluations, known wins (with their progress terms),
+ * tablebase wins (with distance) and mates are stored exactly.
+ */
+struct Band
+{
+    Value begin;
+    Value step;
+};
+
+constexpr Band BANDS[] = {
+    {0, 1},
+    {EXACT_RANGE, COARSE_STEP},
+    {VALUE_KNOWN_WIN, 1},
+    {VALUE_KNOWN_WIN + KNOWN_WIN_RANGE, COARSE_STEP},
+    {VALUE_TB_WIN - TB_WIN_RANGE, 1},
+    {VALUE_TB_WIN + 1, COARSE_STEP},
+    {VALUE_MATE - MATE_RANGE, 1},
+};
+constexpr int NUM_BANDS = sizeof(BANDS) / sizeof(BANDS[0]);
+// last band covers VALUE_INFINITE as well
+constexpr Value BANDS_END = VALUE_INFINITE + 1;
+
+struct BandCodes
+{
+    Value begin[NUM_BANDS + 1];
+};
+
+constexpr BandCodes compute_band_codes()
+{
+    BandCodes codes{};
+    for (int i = 0; i < NUM_BANDS; ++i)
+    {
+        const Value end = i + 1 < NUM_BANDS ? BANDS[i + 1].begin : BANDS_END;
+        codes.begin[i + 1] =
+            codes.begin[i] + (end - BANDS[i].begin + BANDS[i].step - 1) / BANDS[i].step;
+    }
+    return codes;
+}
+
+// first packed code of every band
+constexpr BandCodes BAND_CODES = compute_band_codes();
+
+static_assert(BAND_CODES.begin[NUM_BANDS] - 1 <= INT16_MAX);
+
+int16_t pack_abs_value(Value abs_value, bool round_up)
+{
+    int band = NUM_BANDS - 1;
+    while (abs_value < BANDS[band].begin) --band;
+
+    const Value offset = abs_value - BANDS[band].begin;
+    Value code = BAND_CODES.begin[band] + offset / BANDS[band].step;
+    // next code may be the first one of the next band, which is still above
+    if (round_up && offset % BANDS[band].step != 0) ++code;
+    return static_cast<int16_t>(code);
+}
+
+Value unpack_abs_value(Value code)
+{
+    int band = NUM_BANDS - 1;
+    while (code < BAND_CODES.begin[band]) --band;
+
+    return BANDS[band].begin + (code - BAND_CODES.begin[band]) * BANDS[band].step;
+}
+
+// saved table file format
+constexpr char FILE_MAGIC[8] = {'C', 'P', 'P', 'T', 'T', 0, 0, 0};
+constexpr uint32_t FILE_VERSION = 2;
+// header takes a whole page, so that mapped clusters are page aligned
+constexpr std::size_t FILE_HEADER_SIZE = 4096;
+
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t cluster_size;
+    uint64_t num_clusters;
+    // hash of the starting position, detects different zobrist keys
+    uint64_t key_check;
+    uint8_t epoch;
+};
+
+static_assert(sizeof(FileHeader) <= FILE_HEADER_SIZE);
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+// align the table to the huge page size, so that it can be backed by huge pages
+constexpr std::size_t TABLE_ALIGNMENT = 2 * 1024 * 1024;
+#else
+constexpr std::size_t TABLE_ALIGNMENT = alignof(TTable::Cluster);
+#endif
+
+void* allocate_table(std::size_t size)
+{
+    size = (size + TABLE_ALIGNMENT - 1) / TABLE_ALIGNMENT * TABLE_ALIGNMENT;
+    void* memory = std::aligned_alloc(TABLE_ALIGNMENT, size);
+    if (!memory) throw std::bad_alloc();
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    // only a hint, the table works with regular pages as well
+    madvise(memory, size, MADV_HUGEPAGE);
+#endif
+
+    return memory;
+}
+
+/**
+ * @brief Splits [0, size) into n_threads ranges
+ * and calls function(begin, end) for each of them in a separate thread.
+ */
+template <typename Function>
+void parallel_for(std::size_t size, std::size_t n_threads, Function function)
+{
+    n_threads = std::max<std::size_t>(n_threads, 1);
+    const std::size_t chunk = (size + n_threads - 1) / n_threads;
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 1; t < n_threads; ++t)
+    {
+        const std::size_t begin = std::min(size, t * chunk);
+        const std::size_t end = std::min(size, begin + chunk);
+        threads.emplace_back(function, begin, end);
+    }
+    function(0, std::min(size, chunk));
+
+    for (std::thread& thread : threads) thread.join();
+}
+
+}  // namespace
+
+int16_t pack_value(Value value, Flag flag)
+{
+    if (value == VALUE_NONE) return PACKED_NONE;
+
+    const bool negative = value < 0;
+    // lower bounds are rounded down, upper bounds up
+    // and exact values towards the draw
+    const bool round_up = flag == Flag::kLOWER_BOUND   ? negative
+                          : flag == Flag::kUPPER_BOUND ? !negative
+                                                       : false;
+    const int16_t packed = pack_abs_value(negative ? -value : value, round_up);
+    return negative ? static_cast<int16_t>(-packed) : packed;
+}
+
+Value unpack_value(int16_t packed)
+{
+    if (packed == PACKED_NONE) return VALUE_NONE;
+
+    return packed < 0 ? -unpack_abs_value(-Value(packed)) : unpack_abs_value(packed);
+}
+
+TTable::~TTable()
+{
+    release();
+}
+
+void TTable::release()
+{
+#if defined(__linux__)
+    if (_mapping)
+        munmap(_mapping, _mapping_size);
+    else
+#endif
+        std::free(_clusters);
+
+    _mapping = nullptr;
+    _mapping_size = 0;
+    _clusters = nullptr;
+    _num_clusters = 0;
+}
+
+void TTable::resize(std::size_t size_mb, std::size_t n_threads)
+{
+    const std::size_t num_clusters =
+        std::max<std::size_t>(size_mb * 1024 * 1024 / sizeof(Cluster), 1);
+    if (num_clusters == _num_clusters) return;
+
+    release();
+    _stats = Stats();
+
+    _clusters = static_cast<Cluster*>(allocate_table(num_clusters * sizeof(Cluster)));
+    _num_clusters = num_clusters;
+    // first touch of the pages happens here, so it is done in parallel too
+    parallel_for(_num_clusters, n_threads, [this](std::size_t begin, std::size_t end) {
+        std::uninitialized_value_construct(_clusters + begin, _clusters + end);
+    });
+}
+
+void TTable::clear(std::size_t n_threads)
+{
+    _stats = Stats();
+    parallel_for(_num_clusters, n_threads, [this](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            for (std::size_t j = 0; j < CLUSTER_SIZE; ++j)
+            {
+                _clusters[i].data[j].store(0, std::memory_order_relaxed);
+                _clusters[i].keys[j].store(0, std::memory_order_relaxed);
+            }
+        }
+    });
+}
+
+bool TTable::save(const std::string& path) const
+{
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream) return false;
+
+    char header_buffer[FILE_HEADER_SIZE] = {};
+    FileHeader header;
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.cluster_size = sizeof(Cluster);
+    header.num_clusters = _num_clusters;
+    header.key_check = Position().hash();
+    header.epoch = _epoch;
+    std::memcpy(header_buffer, &header, sizeof(header));
+
+    stream.write(header_buffer, FILE_HEADER_SIZE);
+    stream.write(reinterpret_cast<const char*>(_clusters),
+                 static_cast<std::streamsize>(_num_clusters * sizeof(Cluster)));
+    return static_cast<bool>(stream);
+}
+
+bool TTable::load(const std::string& path)
+{
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream) return false;
+    const std::size_t file_size = static_cast<std::size_t>(stream.tellg());
+
+    FileHeader header;
+    stream.seekg(0);
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return false;
+
+    if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+        header.version != FILE_VERSION ||
+        header.cluster_size != sizeof(Cluster) ||
+        header.num_clusters == 0 ||
+        file_size != FILE_HEADER_SIZE + header.num_clusters * sizeof(Cluster) ||
+        header.key_check != Position().hash())
+        return false;
+
+#if defined(__linux__)
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    // private mapping: pages are read from the file on first access
+    // and writes go to memory only
+    void* mapping = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    release();
+    _mapping = mapping;
+    _mapping_size = file_size;
+    _clusters = reinterpret_cast<Cluster*>(static_cast<char*>(mapping) + FILE_HEADER_SIZE);
+    _num_clusters = header.num_clusters;
+#else
+    release();
+    _clusters = static_cast<Cluster*>(allocate_table(header.num_clusters * sizeof(Cluster)));
+    _num_clusters = header.num_clusters;
+    stream.seekg(FILE_HEADER_SIZE);
+    stream.read(reinterpret_cast<char*>(_clusters),
+                static_cast<std::streamsize>(_num_clusters * sizeof(Cluster)));
+#endif
+
+    _epoch = header.epoch;
+    _stats = Stats();
+    return true;
+}
+
+TTable::Usage TTable::usage() const
+{
+    Usage usage;
+    usage.entries = _num_clusters * CLUSTER_SIZE;
+    for (std::size_t i = 0; i < _num_clusters; ++i)
+    {
+        for (const std::atomic<uint64_t>& data : _clusters[i].data)
+        {
+            const Entry entry(data.load(std::memory_order_relaxed));
+            usage.used += entry.epoch() != 0;
+            usage.current += entry.epoch() == _epoch;
+        }
+    }
+    return usage;
+}
+
+TTable::Stats& TTable::Stats::operator+=(const Stats& other)
+{
+    probes += other.probes;
+    hits += other.hits;
+    collisions += other.collisions;
+    stores += other.stores;
+    replaced += other.replaced;
+    overwrote_deeper += other.overwrote_deeper;
+    kept_deeper += other.kept_deeper;
+    return *this;
+}
+
+std::ostream& operator<<(std::ostream& stream, const TTable::Stats& stats)
+{
+    auto percent = [](uint64_t count, uint64_t total) {
+        return total == 0 ? 0.0 : 100.0 * static_cast<double>(count) / static_cast<double>(total);
+    };
+
+    const std::ios_base::fmtflags flags = stream.flags();
+    const std::streamsize precision = stream.precision();
+    stream << std::fixed << std::setprecision(1)
+           << "probes " << stats.probes
+           << " hits " << stats.hits << " (" << percent(stats.hits, stats.probes) << "%)"
+           << " collisions " << stats.collisions << " (" << percent(stats.collisions, stats.probes) << "%)"
+           << " stores " << stats.stores
+           << " replaced " << stats.replaced << " (" << percent(stats.replaced, stats.stores) << "%)"
+           << " overwrotedeeper " << stats.overwrote_deeper << " (" << percent(stats.overwrote_deeper, stats.stores) << "%)"
+           << " keptdeeper " << stats.kept_deeper;
+    stream.flags(flags);
+    stream.precision(precision);
+    return stream;
+}
+
+}  // namespace tt
+}  // namespace engine
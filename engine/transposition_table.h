@@ -3,8 +3,13 @@
 
 #include "position.h"
 #include "types.h"
+#include "value.h"
 
-#include "hashmap.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
 
 namespace engine
 {
@@ -20,8 +25,9 @@ enum class Flag
 struct TTEntry
 {
     TTEntry() {}
-    TTEntry(int64_t score, int32_t depth, Flag flag, Move move)
-        : score(score), depth(depth), flag(flag), move(move)
+    TTEntry(int64_t score, int32_t depth, Flag flag, Move move,
+            Value eval = VALUE_NONE)
+        : score(score), depth(depth), flag(flag), move(move), eval(eval)
     {
     }
 
@@ -29,9 +35,334 @@ struct TTEntry
     int32_t depth;
     Flag flag;
     Move move;
+    Value eval;
 };
 
-using TTable = HashMap<uint64_t, TTEntry, 4 * 1024 * 1024>;
+/**
+ * @brief Packs value into 16 bits.
+ * Values below 2^14 in magnitude, known wins with small progress terms,
+ * tablebase wins and mates are stored exactly, values between them lose
+ * some precision. They are rounded so that the bound stays valid (lower
+ * bounds down, upper bounds up), exact values are rounded towards
+ * the draw. VALUE_NONE is preserved.
+ */
+int16_t pack_value(Value value, Flag flag = Flag::kEXACT);
+
+Value unpack_value(int16_t packed);
+
+/**
+ * @brief Transposition table made of clusters of packed entries.
+ *
+ * Each position maps to one cluster and can be stored in any of
+ * its entries. When the cluster is full, the entry which is the least
+ * valuable (shallow, from older searches, not exact) gets replaced.
+ *
+ * The table is shared by all search threads without locking.
+ * Entry data is a single 64-bit atomic word and the key is stored xored
+ * with the data, so an entry torn by concurrent writes fails
+ * the key check instead of returning mixed data.
+ */
+class TTable
+{
+  public:
+    /**
+     * @brief Copy of the data of table entry.
+     */
+    struct Entry
+    {
+        Entry() = default;
+        explicit Entry(uint64_t data) : _data(data) {}
+
+        int64_t score() const { return unpack_value(static_cast<int16_t>(_data >> 16)); }
+        Value eval() const { return unpack_value(static_cast<int16_t>(_data >> 32)); }
+        int32_t depth() const { return static_cast<uint8_t>(_data >> 48); }
+        Flag flag() const { return static_cast<Flag>((_data >> 56) & 0x3); }
+        Move move() const { return unpack_move(static_cast<PackedMove>(_data)); }
+        uint8_t epoch() const { return static_cast<uint8_t>(_data >> 58); }
+
+      private:
+        friend class TTable;
+
+        // 0-15 - move
+        // 16-31 - score
+        // 32-47 - static eval
+        // 48-55 - depth
+        // 56-57 - flag
+        // 58-63 - epoch (0 marks an empty entry)
+        uint64_t _data = 0;
+    };
+
+    /**
+     * @brief Counters of table accesses.
+     * Each search thread keeps its own copy, so that counting
+     * doesn't add contention on the shared table.
+     */
+    struct Stats
+    {
+        Stats& operator+=(const Stats& other);
+
+        uint64_t probes = 0;
+        uint64_t hits = 0;
+        // missed probes with no empty entry in the cluster
+        uint64_t collisions = 0;
+        uint64_t stores = 0;
+        // stores which evicted entry of another position
+        uint64_t replaced = 0;
+        // stores which overwrote an entry with bigger depth
+        uint64_t overwrote_deeper = 0;
+        // stores skipped to keep deeper entry of the same position
+        uint64_t kept_deeper = 0;
+    };
+
+    /**
+     * @brief Result of a full scan of the table.
+     */
+    struct Usage
+    {
+        uint64_t entries = 0;
+        uint64_t used = 0;
+        // entries written in the current search
+        uint64_t current = 0;
+    };
+
+    static constexpr std::size_t CLUSTER_SIZE = 3;
+
+    // two clusters per cache line
+    struct alignas(32) Cluster
+    {
+        std::atomic<uint64_t> data[CLUSTER_SIZE];
+        // upper 16 bits of the hash xored with fold(data)
+        std::atomic<uint16_t> keys[CLUSTER_SIZE];
+    };
+
+    static_assert(sizeof(Cluster) == 32, "TT cluster should take half of cache line");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+    static constexpr std::size_t DEFAULT_SIZE_MB = 64;
+
+    TTable() = default;
+    explicit TTable(std::size_t size_mb, std::size_t n_threads = 1)
+    {
+        resize(size_mb, n_threads);
+    }
+    ~TTable();
+
+    TTable(const TTable&) = delete;
+    TTable& operator=(const TTable&) = delete;
+
+    /**
+     * @brief Reallocates the table to take given number of megabytes.
+     * The table is cleared, unless its size doesn't change.
+     * The new table is initialized using n_threads threads.
+     */
+    void resize(std::size_t size_mb, std::size_t n_threads = 1);
+
+    std::size_t size_mb() const
+    {
+        return _num_clusters * sizeof(Cluster) / (1024 * 1024);
+    }
+
+    /**
+     * @brief Looks up position in the table.
+     * Returns copy of the found entry (only valid when found is true).
+     */
+    Entry probe(uint64_t key, bool& found, Stats* stats = nullptr) const
+    {
+        const Cluster& cluster = _clusters[index(key)];
+        const uint16_t key16 = static_cast<uint16_t>(key >> 48);
+        bool full = true;
+        for (std::size_t i = 0; i < CLUSTER_SIZE; ++i)
+        {
+            const Entry entry(cluster.data[i].load(std::memory_order_relaxed));
+            const uint16_t stored = cluster.keys[i].load(std::memory_order_relaxed);
+            if (entry.epoch() != 0 && (stored ^ fold(entry._data)) == key16)
+            {
+                if (stats)
+                {
+                    stats->probes++;
+                    stats->hits++;
+                }
+                found = true;
+                return entry;
+            }
+            full &= entry.epoch() != 0;
+        }
+        if (stats)
+        {
+            stats->probes++;
+            stats->collisions += full;
+        }
+        found = false;
+        return Entry();
+    }
+
+    /**
+     * @brief Starts loading the cluster of given position into cache,
+     * so that it is ready when the position gets probed.
+     */
+    void prefetch(uint64_t key) const
+    {
+        __builtin_prefetch(&_clusters[index(key)]);
+    }
+
+    void insert(uint64_t key, const TTEntry& value, Stats* stats = nullptr)
+    {
+        Cluster& cluster = _clusters[index(key)];
+        const uint16_t key16 = static_cast<uint16_t>(key >> 48);
+
+        std::size_t replace = 0;
+        int32_t replace_worth = INT32_MAX;
+        bool same_position = false;
+        for (std::size_t i = 0; i < CLUSTER_SIZE; ++i)
+        {
+            const Entry entry(cluster.data[i].load(std::memory_order_relaxed));
+            const uint16_t stored = cluster.keys[i].load(std::memory_order_relaxed);
+            if (entry.epoch() != 0 && (stored ^ fold(entry._data)) == key16)
+            {
+                // don't let a much shallower bound from the current search
+                // overwrite a deeper result for the same position
+                if (value.flag != Flag::kEXACT && entry.epoch() == _epoch &&
+                    value.depth + 4 <= entry.depth())
+                {
+                    if (stats) stats->kept_deeper++;
+                    return;
+                }
+
+                replace = i;
+                same_position = true;
+                break;
+            }
+
+            if (worth(entry) < replace_worth)
+            {
+                replace = i;
+                replace_worth = worth(entry);
+            }
+        }
+
+        if (stats)
+        {
+            const Entry old(cluster.data[replace].load(std::memory_order_relaxed));
+            stats->stores++;
+            stats->replaced += !same_position && old.epoch() != 0;
+            stats->overwrote_deeper += old.epoch() != 0 && old.depth() > value.depth;
+        }
+
+        const uint64_t data =
+            uint64_t(pack_move(value.move)) |
+            uint64_t(static_cast<uint16_t>(pack_value(value.score, value.flag))) << 16 |
+            uint64_t(static_cast<uint16_t>(pack_value(value.eval))) << 32 |
+            uint64_t(std::clamp(value.depth, 0, 255)) << 48 |
+            uint64_t(value.flag) << 56 |
+            uint64_t(_epoch) << 58;
+
+        cluster.data[replace].store(data, std::memory_order_relaxed);
+        cluster.keys[replace].store(key16 ^ fold(data), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Clears the table, splitting the work between n_threads threads.
+     */
+    void clear(std::size_t n_threads = 1);
+
+    /**
+     * @brief Saves the table to a file (header followed by raw clusters).
+     * Returns false if the file couldn't be written.
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * @brief Adds counters of a finished search to the table totals.
+     */
+    void add_stats(const Stats& stats) { _stats += stats; }
+
+    /**
+     * @brief Counters summed over searches since the table was last cleared.
+     */
+    const Stats& stats() const { return _stats; }
+
+    /**
+     * @brief Scans whole table, can be slow for big tables.
+     */
+    Usage usage() const;
+
+    /**
+     * @brief Replaces the table with one saved by save().
+     * The file is memory mapped, so entries are read lazily
+     * as they are accessed. Returns false (and keeps the current table)
+     * if the file is missing or wasn't saved by a compatible engine.
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @brief Permille of sampled entries written in the current search.
+     */
+    int32_t hashfull() const
+    {
+        int32_t count = 0;
+        const std::size_t n = std::min(1000 / CLUSTER_SIZE, _num_clusters);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            for (const std::atomic<uint64_t>& data : _clusters[i].data)
+                count += static_cast<int32_t>(
+                    Entry(data.load(std::memory_order_relaxed)).epoch() == _epoch);
+        }
+        return static_cast<int32_t>(count * 1000 / (n * CLUSTER_SIZE));
+    }
+
+    void updateEpoch(uint32_t amount)
+    {
+        _epoch = static_cast<uint8_t>((_epoch - 1 + amount) % MAX_EPOCH + 1);
+    }
+
+    bool isCurrentEpoch(uint8_t epoch) const { return epoch == _epoch; }
+
+  private:
+    // epoch is stored in 6 bits, 0 is reserved for empty entries
+    static constexpr uint32_t MAX_EPOCH = 63;
+
+    /**
+     * @brief Maps lower 32 bits of the key onto [0, _num_clusters),
+     * so that the table size doesn't have to be a power of 2.
+     */
+    std::size_t index(uint64_t key) const
+    {
+        return ((key & 0xFFFFFFFFULL) * _num_clusters) >> 32;
+    }
+
+    /**
+     * @brief Frees table memory (either allocated or mapped from a file).
+     */
+    void release();
+
+    static uint16_t fold(uint64_t data)
+    {
+        return static_cast<uint16_t>(data ^ (data >> 16) ^ (data >> 32) ^ (data >> 48));
+    }
+
+    /**
+     * @brief How valuable the entry is, the least valuable one
+     * in a cluster gets replaced.
+     */
+    int32_t worth(const Entry& entry) const
+    {
+        if (entry.epoch() == 0) return INT32_MIN;
+
+        const int32_t age = (_epoch - entry.epoch() + MAX_EPOCH) % MAX_EPOCH;
+        const int32_t bonus = entry.flag() == Flag::kEXACT ? 2 : 0;
+        return entry.depth() - 8 * age + bonus;
+    }
+
+    Cluster* _clusters = nullptr;
+    std::size_t _num_clusters = 0;
+    // set when the table is mapped from a file
+    void* _mapping = nullptr;
+    std::size_t _mapping_size = 0;
+    uint8_t _epoch = 1;
+    Stats _stats;
+};
+
+std::ostream& operator<<(std::ostream& stream, const TTable::Stats& stats);
 
 }  // namespace tt
 }  // namespace engine
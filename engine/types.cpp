@@ -25,41 +25,19 @@ Castling castling(Move move)
     return p == 0 ? NO_CASTLING : p == 1 ? KING_CASTLING : QUEEN_CASTLING;
 }
 
-MoveInfo create_moveinfo(PieceKind captured, Castling last_castling,
-                         Square last_enpassant, bool enpassant,
-                         uint8_t half_move_counter)
+PackedMove pack_move(Move move)
 {
-    if (last_enpassant != NO_SQUARE)
-        return half_move_counter << 15 | (!!enpassant) << 14 | 1 << 13 |
-               last_enpassant << 7 | last_castling << 3 | captured;
-    return half_move_counter << 15 | enpassant << 14 | last_castling << 3 |
-           captured;
+    Castling c = castling(move);
+    if (c != NO_CASTLING)
+        return PackedMove(1 << 15 | (c == QUEEN_CASTLING ? 1 : 0));
+    return PackedMove(move);
 }
 
-PieceKind captured_piece(MoveInfo moveinfo)
+Move unpack_move(PackedMove packed)
 {
-    return PieceKind(moveinfo & 0x7);
-}
-
-Castling last_castling(MoveInfo moveinfo)
-{
-    return Castling((moveinfo >> 3) & 0xF);
-}
-
-Square last_enpassant_square(MoveInfo moveinfo)
-{
-    if ((moveinfo >> 13) & 0x1) return Square((moveinfo >> 7) & 0x3F);
-    return NO_SQUARE;
-}
-
-bool enpassant(MoveInfo moveinfo)
-{
-    return (moveinfo >> 14) & 0x1;
-}
-
-uint8_t half_move_counter(MoveInfo moveinfo)
-{
-    return (moveinfo >> 15) & 0xFF;
+    if (packed >> 15)
+        return create_castling(packed & 1 ? QUEEN_CASTLING : KING_CASTLING);
+    return Move(packed);
 }
 
 std::ostream& print_bitboard(std::ostream& stream, Bitboard bb)
@@ -15,7 +15,6 @@ namespace engine
 using Depth = int32_t;
 constexpr Depth MAX_DEPTH = 40;
 
-const int32_t MAX_PLIES = 800;
 constexpr int MAX_MOVES = 512;
 constexpr int MAX_PINS = 16;
 
@@ -160,25 +159,15 @@ constexpr Move NO_MOVE = 0;
 constexpr Move KING_CASTLING_MOVE = create_castling(KING_CASTLING);
 constexpr Move QUEEN_CASTLING_MOVE = create_castling(QUEEN_CASTLING);
 
+// 16-bit move encoding (used e.g. in transposition table)
+// 0-5 - from
+// 6-11 - to
+// 12-14 - promotion
+// 15 - castling (then bit 0 is set for queen side castling)
+using PackedMove = uint16_t;
 
-// encoded move information
-// 0-2 - captured piece
-// 3-6 - last castling rights
-// 7-12 - last enpassant square
-// 13-13 - last enpassant
-// 14-14 - enpassant
-// 15-22 - half move counter
-using MoveInfo = uint32_t;
-
-MoveInfo create_moveinfo(PieceKind captured, Castling last_castling,
-                         Square last_enpassant, bool enpassant,
-                         uint8_t half_move_counter);
-
-PieceKind captured_piece(MoveInfo moveinfo);
-Castling last_castling(MoveInfo moveinfo);
-Square last_enpassant_square(MoveInfo moveinfo);
-bool enpassant(MoveInfo moveinfo);
-uint8_t half_move_counter(MoveInfo moveinfo);
+PackedMove pack_move(Move move);
+Move unpack_move(PackedMove packed);
 
 const Castling CASTLING_RIGHTS[COLOR_NUM] = {W_CASTLING, B_CASTLING};
 const Square KING_SIDE_ROOK_SQUARE[COLOR_NUM] = {SQ_H1, SQ_H8};
@@ -382,6 +371,19 @@ constexpr PieceCountVector modify_pcv(PieceCountVector pcv, int c)
     return (pcv & ~(C(0xF) << C(4 * piece))) | (C(c) << C(4 * piece));
 }
 
+/*
+ * Swaps white and black piece counts.
+ */
+constexpr PieceCountVector flip_pcv(PieceCountVector pcv)
+{
+    constexpr uint64_t shift = 4 * (B_PAWN - W_PAWN);
+    constexpr PieceCountVector white_mask = (C(1) << shift) - 1;
+    return ((pcv & white_mask) << shift) | ((pcv >> shift) & white_mask);
+}
+
+static_assert(flip_pcv(create_pcv(1, 2, 3, 4, 5, 6, 7, 8, 9, 1)) ==
+              create_pcv(6, 7, 8, 9, 1, 1, 2, 3, 4, 5));
+
 #undef C
 
 }  // namespace engine
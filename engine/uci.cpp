@@ -1,14 +1,17 @@
 #include "uci.h"
 
+#include <iomanip>
 #include <thread>
 
 #include "logger.h"
+#include "nnue.h"
+#include "tablebase.h"
 #include "transposition_table.h"
 #include "chessplusplusConfig.h"
 
 namespace engine
 {
-Uci::Uci() : search(nullptr), position(), quit(false), options(), polyglot(), polyglot_sample_random_move(true)
+Uci::Uci() : search(nullptr), position(), scorers(), quit(false), options(), polyglot(), polyglot_sample_random_move(true)
 {
     options["Polyglot Book"] = UciOption("", [this](std::string path) {
         if (path == "")
@@ -30,6 +33,32 @@ Uci::Uci() : search(nullptr), position(), quit(false), options(), polyglot(), po
         else
             logger.open_file(path);
     });
+    options["EvalFile"] = UciOption("", [this](std::string path) {
+        if (path == "")
+            nnue::unload();
+        else if (!nnue::load(path))
+            sync_cout << "info string Cannot load network " << path << sync_endl;
+        // cached evaluations could come from the other evaluation
+        for (PositionScorer& scorer : this->scorers) scorer.eval_cache().clear();
+    });
+    options["TablebasePath"] = UciOption("", [](std::string path) {
+        if (path == "")
+            tablebase::release();
+        else
+            sync_cout << "info string Loaded " << tablebase::init(path) << " tablebases" << sync_endl;
+    });
+    options["EvalCache"] = UciOption(EvalCache::DEFAULT_SIZE_MB, 0, 1024, [this](int size_mb) {
+        for (PositionScorer& scorer : this->scorers) scorer.eval_cache().resize(size_mb);
+    });
+    options["Threads"] = UciOption(1, 1, 512, [this](int threads) {
+        this->scorers.resize(threads);
+        // new scorers have the default eval cache size
+        const int size_mb = this->options["EvalCache"].get_spin_initial();
+        for (PositionScorer& scorer : this->scorers) scorer.eval_cache().resize(size_mb);
+    });
+    options["Hash"] = UciOption(tt::TTable::DEFAULT_SIZE_MB, 1, 65536, [this](int size_mb) {
+        this->ttable.resize(size_mb, this->scorers.size());
+    });
 }
 
 void Uci::loop()
@@ -76,6 +105,10 @@ void Uci::loop()
         COMMAND(perft)
         COMMAND(moves)
         COMMAND(staticeval)
+        COMMAND(savett)
+        COMMAND(loadtt)
+        COMMAND(ttstats)
+        COMMAND(gentb)
 
 #undef COMMAND
 
@@ -84,6 +117,8 @@ void Uci::loop()
             sync_cout << "Unknown command" << sync_endl;
         }
     }
+
+    wait_for_clear();
 }
 
 bool Uci::uci_command(std::istringstream& /* istream */)
@@ -130,11 +165,32 @@ bool Uci::uci_command(std::istringstream& /* istream */)
 bool Uci::ucinewgame_command(std::istringstream& /* istream */)
 {
     position = Position();
-    scorer.clear();
-    ttable.clear();
+    clear_tables();
     return true;
 }
 
+void Uci::clear_tables()
+{
+    // nothing touches the tables before waiting for the clear,
+    // so a pending clear is still good enough
+    if (clear_thread.joinable()) return;
+
+    // clearing big tables takes a while, so it is done in the background
+    // (isready answers immediately) and go waits for it to finish
+    clear_thread = std::thread([this]() {
+        std::vector<std::thread> threads;
+        for (PositionScorer& scorer : scorers)
+            threads.emplace_back([&scorer]() { scorer.clear(); });
+        ttable.clear(scorers.size());
+        for (std::thread& thread : threads) thread.join();
+    });
+}
+
+void Uci::wait_for_clear()
+{
+    if (clear_thread.joinable()) clear_thread.join();
+}
+
 bool Uci::isready_command(std::istringstream& /* istream */)
 {
     sync_cout << "readyok" << sync_endl;
@@ -155,6 +211,8 @@ bool Uci::setoption_command(std::istringstream& istream)
 
     if (options.find(name) == options.end()) return false;
 
+    wait_for_clear();
+
     OptionType optiontype = options[name].get_type();
 
     if (optiontype == kCHECK)
@@ -224,7 +282,7 @@ bool Uci::staticeval_command(std::istringstream& /* istream */)
     PositionScorer scorer;
     Value score = scorer.score(position);
     std::cout << "Score: " << score2str(score) << sync_endl;
-    scorer.print_stats();
+    scorer.print_stats(position);
     return true;
 }
 
@@ -241,6 +299,82 @@ bool Uci::moves_command(std::istringstream& istream)
     return true;
 }
 
+bool Uci::savett_command(std::istringstream& istream)
+{
+    std::string path;
+    if (!(istream >> path)) return false;
+
+    wait_for_clear();
+    if (!ttable.save(path))
+        sync_cout << "info string Cannot save transposition table to " << path << sync_endl;
+    return true;
+}
+
+bool Uci::loadtt_command(std::istringstream& istream)
+{
+    std::string path;
+    if (!(istream >> path)) return false;
+
+    wait_for_clear();
+    if (!ttable.load(path))
+    {
+        sync_cout << "info string Cannot load transposition table from " << path << sync_endl;
+        return true;
+    }
+
+    // keep Hash option in sync, table has the same size so it won't be reallocated
+    options["Hash"].set(static_cast<int>(ttable.size_mb()));
+    return true;
+}
+
+bool Uci::ttstats_command(std::istringstream& /* istream */)
+{
+    wait_for_clear();
+
+    auto percent = [](uint64_t count, uint64_t total) {
+        std::ostringstream stream;
+        stream << std::fixed << std::setprecision(2)
+               << (total == 0 ? 0.0 : 100.0 * static_cast<double>(count) / static_cast<double>(total));
+        return stream.str();
+    };
+
+    const tt::TTable::Usage usage = ttable.usage();
+    sync_cout << "Size: " << ttable.size_mb() << "MB" << std::endl
+              << "Entries: " << usage.entries << std::endl
+              << "Used: " << usage.used << " (" << percent(usage.used, usage.entries) << "%)" << std::endl
+              << "Current search: " << usage.current << " (" << percent(usage.current, usage.entries) << "%)" << std::endl
+              << "Since last clear: " << ttable.stats() << std::endl;
+
+    EvalCache::Stats eval_stats;
+    for (const PositionScorer& scorer : scorers)
+    {
+        eval_stats.probes += scorer.eval_cache().stats().probes;
+        eval_stats.hits += scorer.eval_cache().stats().hits;
+    }
+    std::cout << "Eval cache: probes " << eval_stats.probes
+              << " hits " << eval_stats.hits << " (" << percent(eval_stats.hits, eval_stats.probes) << "%)"
+              << sync_endl;
+    return true;
+}
+
+bool Uci::gentb_command(std::istringstream& istream)
+{
+    std::string path;
+    if (!(istream >> path)) return false;
+
+    int max_pieces = tablebase::MAX_PIECES;
+    istream >> max_pieces;
+
+    wait_for_clear();
+    // generated tables stay loaded
+    const int count = tablebase::generate(path, max_pieces, std::cout);
+    if (count < 0)
+        sync_cout << "info string Cannot write tablebases to " << path << sync_endl;
+    else
+        sync_cout << "info string Generated " << count << " tablebases" << sync_endl;
+    return true;
+}
+
 void start_searching(Uci* uci)
 {
     uint64_t key = PolyglotBook::hash(uci->position);
@@ -292,7 +426,8 @@ bool Uci::go_command(std::istringstream& istream)
         }
     }
 
-    search = std::make_shared<Search>(position, limits, scorer, ttable);
+    wait_for_clear();
+    search = std::make_shared<Search>(position, limits, scorers, ttable);
 
     std::thread search_thread(start_searching, this);
     search_thread.detach();
@@ -341,17 +476,18 @@ bool Uci::perft_command(std::istringstream& istream)
     uint64_t sum = 0;
     if (depth > 0)
     {
-        Move* begin = MOVE_LIST[depth];
+        Move moves[MAX_MOVES];
+        Move* begin = moves;
         Move* end = generate_moves(position, position.color(), begin);
 
         for (Move* it = begin; it != end; ++it)
         {
             Move move = *it;
-            MoveInfo moveinfo = position.do_move(move);
+            position.do_move(move);
 
             uint64_t n = perft(position, depth - 1);
 
-            position.undo_move(move, moveinfo);
+            position.undo_move(move);
 
             sync_cout << position.uci(move) << ": " << n << sync_endl;
             sum += n;
@@ -368,6 +504,7 @@ bool Uci::perft_command(std::istringstream& istream)
     sync_cout << "Time: " << duration << "ms" << sync_endl;
     sync_cout << "Speed: " << sum * 1000LL / (duration + 1) << "nps"
               << sync_endl;
+    sync_cout << "Slider attacks: " << SLIDER_ATTACKS_BACKEND << sync_endl;
 
     return true;
 }
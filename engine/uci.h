@@ -11,6 +11,8 @@
 #include <map>
 #include <memory>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 namespace engine
 {
@@ -53,10 +55,31 @@ class Uci
 
     bool staticeval_command(std::istringstream& istream);
 
+    bool savett_command(std::istringstream& istream);
+
+    bool loadtt_command(std::istringstream& istream);
+
+    bool ttstats_command(std::istringstream& istream);
+
+    bool gentb_command(std::istringstream& istream);
+
+    /**
+     * @brief Starts clearing hash tables in the background.
+     */
+    void clear_tables();
+
+    /**
+     * @brief Waits until tables are cleared, must be called
+     * before anything else touches the tables.
+     */
+    void wait_for_clear();
+
     std::shared_ptr<Search> search;
     Position position;
-    PositionScorer scorer;
+    // one scorer for each search thread
+    std::vector<PositionScorer> scorers;
     tt::TTable ttable;
+    std::thread clear_thread;
     bool is_search;
     bool quit;
 
@@ -47,6 +47,14 @@ struct Score
 
         return *this;
     }
+
+    constexpr Score& operator-=(const Score& other)
+    {
+        mg -= other.mg;
+        eg -= other.eg;
+
+        return *this;
+    }
 };
 
 constexpr Score operator*(const Value& value, const Score& score)
@@ -82,6 +90,14 @@ constexpr Value VALUE_KNOWN_WIN = VALUE_MATE - 8 * MAX_DEPTH - 8 * VALUE_ALL_PIE
 
 static_assert(VALUE_ALL_PIECES < VALUE_KNOWN_WIN);
 
+/**
+ * @brief Value of tablebase win (without distance to mate),
+ * above evaluations of known wins and below mates.
+ */
+constexpr Value VALUE_TB_WIN = VALUE_KNOWN_WIN + 4 * VALUE_ALL_PIECES;
+
+static_assert(VALUE_TB_WIN < VALUE_MATE - 2 * MAX_DEPTH);
+
 /**
  * @brief Value corresponding to known mate (win) in given ply.
  */
@@ -98,6 +114,20 @@ constexpr Value lost_in(int ply)
     return -win_in(ply);
 }
 
+/**
+ * @brief Value of tablebase win reached in given ply,
+ * shorter conversions are preferred.
+ */
+constexpr Value tb_win_in(int ply)
+{
+    return VALUE_TB_WIN - ply;
+}
+
+constexpr Value tb_lost_in(int ply)
+{
+    return -tb_win_in(ply);
+}
+
 constexpr bool is_mate(Value score)
 {
     ASSERT(score != VALUE_NONE && score != VALUE_INFINITE && score != -VALUE_INFINITE);
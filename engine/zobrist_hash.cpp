@@ -1,9 +1,13 @@
 #include "zobrist_hash.h"
 
+#include "move_bitboards.h"
 #include "position.h"
 #include "types.h"
 
+#include <algorithm>
+#include <cassert>
 #include <random>
+#include <utility>
 
 namespace engine
 {
@@ -11,22 +15,81 @@ uint64_t PIECE_HASH[PIECE_NUM][SQUARE_NUM];
 uint64_t CASTLING_HASH[1 << 4];
 uint64_t SIDE_HASH;
 uint64_t ENPASSANT_HASH[FILE_NUM];
+// indexed by number of pieces of given type before the piece
+uint64_t MATERIAL_HASH[PIECE_NUM][16];
 
 namespace zobrist
 {
 
+uint64_t CUCKOO_KEYS[CUCKOO_SIZE];
+Move CUCKOO_MOVES[CUCKOO_SIZE];
+
 namespace
 {
 
+// fixed seed, so that hash keys are the same in every run
+// (required e.g. for transposition tables saved to file)
+constexpr uint64_t ZOBRIST_SEED = 0x3243F6A8885A308DULL;
+
 uint64_t random_uint64()
 {
-    static std::random_device rd;
-    static std::mt19937_64 eng(rd());
+    static std::mt19937_64 eng(ZOBRIST_SEED);
     static std::uniform_int_distribution<uint64_t> dist;
 
     return dist(eng);
 }
 
+Bitboard empty_board_attacks(PieceKind piece_kind, Square square)
+{
+    switch (piece_kind)
+    {
+    case KNIGHT: return KNIGHT_MASK[square];
+    case BISHOP: return pseudoattacks<BISHOP>(square);
+    case ROOK: return pseudoattacks<ROOK>(square);
+    case QUEEN: return pseudoattacks<QUEEN>(square);
+    case KING: return KING_MASK[square];
+    default: return 0ULL;
+    }
+}
+
+void init_cuckoo()
+{
+    std::fill_n(CUCKOO_KEYS, CUCKOO_SIZE, 0ULL);
+    std::fill_n(CUCKOO_MOVES, CUCKOO_SIZE, NO_MOVE);
+
+    int count = 0;
+    for (Piece piece = W_KNIGHT; piece <= B_KING; ++piece)
+    {
+        const PieceKind piece_kind = get_piece_kind(piece);
+        if (piece_kind == PAWN) continue;
+
+        for (Square s1 = SQ_A1; s1 <= SQ_H8; ++s1)
+        {
+            for (Square s2 = Square(s1 + 1); s2 <= SQ_H8; ++s2)
+            {
+                if (!(empty_board_attacks(piece_kind, s1) & square_bb(s2)))
+                    continue;
+
+                Move move = create_move(s1, s2);
+                uint64_t key = PIECE_HASH[piece][s1] ^ PIECE_HASH[piece][s2] ^ SIDE_HASH;
+
+                // insert, kicking out entries until an empty slot is found
+                int i = cuckoo_h1(key);
+                while (true)
+                {
+                    std::swap(CUCKOO_KEYS[i], key);
+                    std::swap(CUCKOO_MOVES[i], move);
+                    if (move == NO_MOVE) break;
+                    i = i == cuckoo_h1(key) ? cuckoo_h2(key) : cuckoo_h1(key);
+                }
+                count++;
+            }
+        }
+    }
+    assert(count == 3668);
+    (void)count;
+}
+
 }  // namespace
 
 void init()
@@ -41,61 +104,57 @@ void init()
 
     for (File file = FILE_A; file <= FILE_H; ++file)
         ENPASSANT_HASH[file] = random_uint64();
+
+    for (Piece piece = Piece(0); piece < PIECE_NUM; ++piece)
+        for (int count = 0; count < 16; ++count)
+            MATERIAL_HASH[piece][count] = random_uint64();
+
+    init_cuckoo();
+}
+
+uint64_t material_key(PieceCountVector pcv)
+{
+    uint64_t key = MATERIAL_HASH[W_KING][0] ^ MATERIAL_HASH[B_KING][0];
+    for (Piece piece = W_PAWN; piece <= B_QUEEN; ++piece)
+    {
+        if (get_piece_kind(piece) == KING) continue;
+        const int count = int((pcv >> (4 * piece)) & 0xF);
+        for (int i = 0; i < count; ++i) key ^= MATERIAL_HASH[piece][i];
+    }
+    return key;
 }
 
 
 }  // namespace zobrist
 
 HashKey::HashKey()
-    : _piece_key(0ULL),
+    : _key(0ULL),
       _pawn_key(0ULL),
+      _material_key(0ULL),
       _enpassant_key(0ULL),
-      _castling_key(0ULL),
-      _color_key(0ULL)
+      _castling_key(0ULL)
 {
 }
 
 void HashKey::init(const Position& position)
 {
-    if (position.color() == BLACK) _color_key ^= SIDE_HASH;
+    *this = HashKey();
+
+    if (position.color() == BLACK) _key ^= SIDE_HASH;
 
-    for (Color color : {WHITE, BLACK})
+    for (Piece piece = W_PAWN; piece <= B_KING; ++piece)
     {
-        Piece piece = make_piece(color, PAWN);
         for (int i = 0; i < position.number_of_pieces(piece); ++i)
         {
-            Square square = position.piece_position(piece, i);
-            _pawn_key ^= PIECE_HASH[piece][square];
+            toggle_piece(piece, position.piece_position(piece, i));
+            _material_key ^= MATERIAL_HASH[piece][i];
         }
     }
 
-    for (Color color : {WHITE, BLACK})
-    {
-        for (PieceKind piece_kind : {KNIGHT, BISHOP, ROOK, QUEEN, KING})
-        {
-            Piece piece = make_piece(color, piece_kind);
-            for (int i = 0; i < position.number_of_pieces(piece); ++i)
-            {
-                Square square = position.piece_position(piece, i);
-                _piece_key ^= PIECE_HASH[piece][square];
-            }
-        }
-    }
-
-    _castling_key ^= CASTLING_HASH[position.castling_rights()];
+    set_castling(position.castling_rights());
 
     if (position.enpassant_square() != NO_SQUARE)
-        _enpassant_key ^= ENPASSANT_HASH[file(position.enpassant_square())];
-}
-
-uint64_t HashKey::get_key() const
-{
-    return _piece_key ^ _pawn_key ^ _enpassant_key ^ _castling_key ^ _color_key;
-}
-
-uint64_t HashKey::get_pawnkey() const
-{
-    return _pawn_key;
+        set_enpassant(file(position.enpassant_square()));
 }
 
 void HashKey::move_piece(Piece piece, Square from, Square to)
@@ -106,34 +165,42 @@ void HashKey::move_piece(Piece piece, Square from, Square to)
 
 void HashKey::toggle_piece(Piece piece, Square sq)
 {
-    if (get_piece_kind(piece) == PAWN)
-        _pawn_key ^= PIECE_HASH[piece][sq];
-    else
-        _piece_key ^= PIECE_HASH[piece][sq];
+    _key ^= PIECE_HASH[piece][sq];
+    if (get_piece_kind(piece) == PAWN) _pawn_key ^= PIECE_HASH[piece][sq];
+}
+
+void HashKey::toggle_material(Piece piece, int count)
+{
+    assert(get_piece_kind(piece) != KING && 0 <= count && count < 16);
+    _material_key ^= MATERIAL_HASH[piece][count];
 }
 
 void HashKey::flip_side()
 {
-    _color_key ^= SIDE_HASH;
+    _key ^= SIDE_HASH;
 }
 
 void HashKey::clear_enpassant()
 {
+    _key ^= _enpassant_key;
     _enpassant_key = 0ULL;
 }
 
 void HashKey::set_enpassant(File file)
 {
+    _key ^= _enpassant_key ^ ENPASSANT_HASH[file];
     _enpassant_key = ENPASSANT_HASH[file];
 }
 
 void HashKey::clear_castling()
 {
+    _key ^= _castling_key;
     _castling_key = 0ULL;
 }
 
 void HashKey::set_castling(Castling castling)
 {
+    _key ^= _castling_key ^ CASTLING_HASH[castling];
     _castling_key = CASTLING_HASH[castling];
 }
 
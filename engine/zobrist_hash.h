@@ -12,8 +12,32 @@ namespace zobrist
 
 void init();
 
+/*
+ * Cuckoo tables with all reversible moves (non-pawn piece going
+ * between two squares it attacks on empty board), indexed by the
+ * change of the hash key the move makes (side flip included).
+ * Used to detect that a move back to an earlier position exists.
+ */
+constexpr int CUCKOO_SIZE = 8192;
+
+extern uint64_t CUCKOO_KEYS[CUCKOO_SIZE];
+extern Move CUCKOO_MOVES[CUCKOO_SIZE];
+
+inline int cuckoo_h1(uint64_t key) { return key & (CUCKOO_SIZE - 1); }
+inline int cuckoo_h2(uint64_t key) { return (key >> 16) & (CUCKOO_SIZE - 1); }
+
+/*
+ * Material key of given piece counts (with one king per side),
+ * equal to HashKey::get_materialkey() of positions with that material.
+ */
+uint64_t material_key(PieceCountVector pcv);
+
 }  // namespace zobrist
 
+/*
+ * Zobrist keys of a position, all updated incrementally:
+ * full key, key of pawns only and key of material (piece counts).
+ */
 class HashKey
 {
   public:
@@ -21,14 +45,21 @@ class HashKey
 
     void init(const Position& position);
 
-    uint64_t get_key() const;
+    uint64_t get_key() const { return _key; }
+
+    uint64_t get_pawnkey() const { return _pawn_key; }
 
-    uint64_t get_pawnkey() const;
+    uint64_t get_materialkey() const { return _material_key; }
 
     void move_piece(Piece piece, Square from, Square to);
 
     void toggle_piece(Piece piece, Square sq);
 
+    /*
+     * Adds or removes count-th (counting from 0) piece of given type.
+     */
+    void toggle_material(Piece piece, int count);
+
     void flip_side();
 
     void clear_enpassant();
@@ -40,11 +71,13 @@ class HashKey
     void set_castling(Castling castling);
 
   private:
-    uint64_t _piece_key;
+    uint64_t _key;
     uint64_t _pawn_key;
+    uint64_t _material_key;
+
+    // parts of _key that are replaced, not toggled
     uint64_t _enpassant_key;
     uint64_t _castling_key;
-    uint64_t _color_key;
 };
 
 }  // namespace engine
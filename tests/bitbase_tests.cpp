@@ -37,4 +37,21 @@ TEST(bibase, correctness)
     }
 }
 
+TEST(bibase, compiledMatchesGenerated)
+{
+    const std::vector<uint32_t> bitbase = bitbase::generate();
+
+    for (Color side : {WHITE, BLACK})
+    for (Square wKing = SQ_A1; wKing <= SQ_H8; ++wKing)
+    for (Square bKing = SQ_A1; bKing <= SQ_H8; ++bKing)
+    for (Rank rank = RANK_2; rank <= RANK_7; ++rank)
+    for (File file = FILE_A; file <= FILE_D; ++file)
+    {
+        const Square wPawn = make_square(rank, file);
+        const uint32_t index = bitbase::get_index(side, wKing, wPawn, bKing);
+        ASSERT_EQ(bitbase::check(side, wKing, wPawn, bKing),
+                  bool(bitbase[index / 32] & (1 << (index & 0x1F))));
+    }
+}
+
 }  // namespace anonymous
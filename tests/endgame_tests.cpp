@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+
+#include "endgame.h"
+#include "position.h"
+
+using namespace engine;
+
+namespace
+{
+
+TEST(EndgameTest, dispatch)
+{
+    // positions without specialized endgame
+    for (const std::string& fen : {
+             Position::STARTPOS_FEN,
+             std::string("8/8/4k3/8/2pp4/8/3RK3/8 w - - 0 1"),
+             std::string("8/5k2/8/8/3B4/8/2PPK3/6n1 w - - 0 1"),
+         })
+        EXPECT_EQ(endgame::score(Position(fen)), VALUE_NONE) << fen;
+
+    // white and mirrored black versions of specialized endgames
+    using TestCase = std::pair<std::string, std::string>;
+    const std::vector<TestCase> test_cases = {
+        // KRKP
+        {"8/8/4k3/8/2p5/8/3RK3/8 w - - 0 1", "8/3rk3/8/2P5/8/4K3/8/8 b - - 0 1"},
+        // KPsK
+        {"8/8/4k3/8/8/2PP4/3K4/8 w - - 0 1", "8/3k4/2pp4/8/8/4K3/8/8 b - - 0 1"},
+        // KBPsK
+        {"8/8/4k3/8/8/2PPB3/3K4/8 w - - 0 1", "8/3k4/2ppb3/8/8/4K3/8/8 b - - 0 1"},
+        // KBPsKB
+        {"8/8/4k3/5b2/8/2PPB3/3K4/8 w - - 0 1", "8/3k4/2ppb3/8/5B2/4K3/8/8 b - - 0 1"},
+        // KQKRPs
+        {"8/8/4k3/3rp3/8/4Q3/3K4/8 w - - 0 1", "8/3k4/4q3/8/3RP3/4K3/8/8 b - - 0 1"},
+        // KmmKm
+        {"8/8/4k3/4n3/8/3BB3/3K4/8 w - - 0 1", "8/3k4/3bb3/8/4N3/4K3/8/8 b - - 0 1"},
+        // KRKB
+        {"8/8/4k3/4b3/8/4R3/3K4/8 w - - 0 1", "8/3k4/4r3/8/4B3/4K3/8/8 b - - 0 1"},
+        // KXK
+        {"8/8/4k3/8/8/2QPR3/3K4/8 w - - 0 1", "8/3k4/2qpr3/8/8/4K3/8/8 b - - 0 1"},
+    };
+
+    for (const TestCase& test_case : test_cases)
+    {
+        const Value value = endgame::score(Position(test_case.first));
+        EXPECT_NE(value, VALUE_NONE) << test_case.first;
+        EXPECT_EQ(value, endgame::score(Position(test_case.second))) << test_case.first;
+    }
+}
+
+}  // namespace
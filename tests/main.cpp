@@ -2,6 +2,7 @@
 
 #include "endgame.h"
 #include "move_bitboards.h"
+#include "psqt.h"
 #include "zobrist_hash.h"
 
 int main(int argc, char** argv)
@@ -11,8 +12,8 @@ int main(int argc, char** argv)
     testing::InitGoogleTest(&argc, argv);
 
     move_bitboards::init();
+    psqt::init();
     zobrist::init();
-    bitbase::init();
     endgame::init();
 
     return RUN_ALL_TESTS();
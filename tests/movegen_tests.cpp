@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include "movegen.h"
+#include "position.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+using namespace engine;
+
+namespace
+{
+
+TEST(MovegenTest, concurrentPerft)
+{
+    using TestCase = std::tuple<std::string, int, uint64_t>;
+
+    const std::vector<TestCase> test_cases = {
+        {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 4, 197281ULL},
+        {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - ", 3, 97862ULL},
+        {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - ", 4, 43238ULL},
+        {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 3, 9467ULL},
+    };
+
+    std::vector<uint64_t> results(test_cases.size(), 0);
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < test_cases.size(); ++i)
+    {
+        threads.emplace_back([&test_cases, &results, i]() {
+            Position position(std::get<0>(test_cases[i]));
+            results[i] = perft(position, std::get<1>(test_cases[i]));
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    for (uint32_t i = 0; i < test_cases.size(); ++i)
+        EXPECT_EQ(results[i], std::get<2>(test_cases[i])) << std::get<0>(test_cases[i]);
+}
+
+const std::vector<std::string> TEST_FENS = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - ",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - ",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+
+/**
+ * @brief Calls check(position) for test positions and positions
+ * reached from them by random moves.
+ */
+template <typename Check>
+void for_each_test_position(Check check)
+{
+    std::mt19937 rng(1234);
+    for (const std::string& fen : TEST_FENS)
+    {
+        for (int game = 0; game < 10; ++game)
+        {
+            Position position(fen);
+            for (int ply = 0; ply < 40; ++ply)
+            {
+                check(position);
+
+                Move moves[MAX_MOVES];
+                Move* end = generate_moves(position, position.color(), moves);
+                if (end == moves) break;
+                position.do_move(moves[rng() % (end - moves)]);
+            }
+        }
+    }
+}
+
+TEST(MovegenTest, capturesAndQuietsMakeAllMoves)
+{
+    for_each_test_position([](const Position& position) {
+        Move all[MAX_MOVES];
+        Move* all_end = generate_moves(position, position.color(), all);
+
+        Move split[MAX_MOVES];
+        Move* split_end = generate_moves<CAPTURES>(position, position.color(), split);
+        for (Move* it = split; it != split_end; ++it)
+            EXPECT_FALSE(position.move_is_quiet(*it)) << position.fen() << " " << position.uci(*it);
+        Move* quiets = split_end;
+        split_end = generate_moves<QUIETS>(position, position.color(), split_end);
+        for (Move* it = quiets; it != split_end; ++it)
+            EXPECT_TRUE(position.move_is_quiet(*it)) << position.fen() << " " << position.uci(*it);
+
+        std::sort(all, all_end);
+        std::sort(split, split_end);
+        EXPECT_EQ(std::vector<Move>(all, all_end), std::vector<Move>(split, split_end))
+            << position.fen();
+    });
+}
+
+TEST(MovegenTest, isMoveLegal)
+{
+    for_each_test_position([](const Position& position) {
+        Move moves[MAX_MOVES];
+        Move* end = generate_moves(position, position.color(), moves);
+
+        std::vector<Move> candidates = {KING_CASTLING_MOVE, QUEEN_CASTLING_MOVE};
+        for (Square from_sq = SQ_A1; from_sq <= SQ_H8; ++from_sq)
+        {
+            for (Square to_sq = SQ_A1; to_sq <= SQ_H8; ++to_sq)
+            {
+                candidates.push_back(create_move(from_sq, to_sq));
+                for (PieceKind kind : {KNIGHT, BISHOP, ROOK, QUEEN})
+                    candidates.push_back(create_promotion(from_sq, to_sq, kind));
+            }
+        }
+
+        for (Move move : candidates)
+            EXPECT_EQ(is_move_legal(position, move), std::find(moves, end, move) != end)
+                << position.fen() << " " << position.uci(move);
+    });
+}
+
+}  // namespace
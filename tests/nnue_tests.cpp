@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+
+#include "movegen.h"
+#include "nnue.h"
+#include "position.h"
+#include "score.h"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+using namespace engine;
+
+namespace
+{
+
+/**
+ * @brief Writes tiny network with random weights.
+ * Real networks don't fit into repository (40960 features
+ * take 1.3MB even with 16 neurons), so the test one is generated.
+ */
+void write_network(const std::string& path, uint32_t half_dimensions, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> small(-8, 8);
+    std::uniform_int_distribution<int> large(-64, 64);
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    auto write16 = [&stream](std::size_t count, auto& distribution, std::mt19937& rng) {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const int16_t value = static_cast<int16_t>(distribution(rng));
+            stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+    };
+    auto write32 = [&stream](std::size_t count, auto& distribution, std::mt19937& rng) {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const int32_t value = distribution(rng) * 64;
+            stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+    };
+
+    const char magic[8] = {'C', 'P', 'P', 'N', 'N', 'U', 'E', 0};
+    const uint32_t version = nnue::FILE_VERSION;
+    stream.write(magic, sizeof(magic));
+    stream.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    stream.write(reinterpret_cast<const char*>(&half_dimensions), sizeof(half_dimensions));
+
+    const std::size_t n = half_dimensions;
+    const std::size_t hidden = nnue::HIDDEN_DIMENSIONS;
+    write16(n, large, rng);
+    write16(nnue::FEATURE_DIMENSIONS * n, small, rng);
+    write32(hidden, large, rng);
+    write16(hidden * 2 * n, large, rng);
+    write32(hidden, large, rng);
+    write16(hidden * hidden, large, rng);
+    write32(1, large, rng);
+    write16(hidden, large, rng);
+}
+
+class NnueTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        path = (std::filesystem::temp_directory_path() / "chessplusplus_nnue_test.bin").string();
+        write_network(path, 16, 1234);
+        ASSERT_TRUE(nnue::load(path));
+    }
+
+    void TearDown() override
+    {
+        nnue::unload();
+        std::filesystem::remove(path);
+    }
+
+    std::string path;
+};
+
+TEST_F(NnueTest, rejectsBadFiles)
+{
+    EXPECT_FALSE(nnue::load(path + ".missing"));
+
+    const std::string bad_path = path + ".bad";
+    {
+        std::ofstream stream(bad_path, std::ios::binary | std::ios::trunc);
+        stream << "not a network";
+    }
+    EXPECT_FALSE(nnue::load(bad_path));
+
+    // truncated file
+    std::filesystem::copy_file(path, bad_path, std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::resize_file(bad_path, std::filesystem::file_size(path) - 2);
+    EXPECT_FALSE(nnue::load(bad_path));
+    std::filesystem::remove(bad_path);
+
+    // previous network is kept
+    EXPECT_TRUE(nnue::is_loaded());
+}
+
+TEST_F(NnueTest, incrementalUpdates)
+{
+    const std::vector<std::string> fens = {
+        Position::STARTPOS_FEN,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+
+    std::mt19937 rng(1234);
+    for (const std::string& fen : fens)
+    {
+        Position position(fen);
+        ASSERT_TRUE(nnue::is_current(position.accumulator()));
+        const Value start_value = nnue::evaluate(position);
+
+        std::vector<Move> played;
+        for (int ply = 0; ply < 40; ++ply)
+        {
+            Move moves[MAX_MOVES];
+            Move* end = generate_moves(position, position.color(), moves);
+            if (end == moves) break;
+
+            const Move move = moves[rng() % (end - moves)];
+            position.do_move(move);
+            played.push_back(move);
+
+            ASSERT_TRUE(nnue::is_current(position.accumulator()));
+            EXPECT_EQ(nnue::evaluate(position), nnue::evaluate(Position(position.fen())))
+                << position.fen();
+        }
+
+        for (auto it = played.rbegin(); it != played.rend(); ++it)
+            position.undo_move(*it);
+        EXPECT_EQ(nnue::evaluate(position), start_value) << fen;
+    }
+}
+
+TEST_F(NnueTest, staleAccumulator)
+{
+    Position position("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    const Value value = nnue::evaluate(position);
+
+    // network is reloaded, old accumulator is not used anymore
+    write_network(path, 32, 4321);
+    ASSERT_TRUE(nnue::load(path));
+    EXPECT_FALSE(nnue::is_current(position.accumulator()));
+    const Value new_value = nnue::evaluate(position);
+
+    position.refresh_accumulator();
+    EXPECT_TRUE(nnue::is_current(position.accumulator()));
+    EXPECT_EQ(nnue::evaluate(position), new_value);
+    EXPECT_NE(value, new_value);
+
+    // scorer uses network only when it is loaded
+    PositionScorer scorer;
+    EXPECT_EQ(scorer.score(position), new_value);
+    nnue::unload();
+    EXPECT_FALSE(nnue::is_current(position.accumulator()));
+}
+
+TEST(NnueKernelTest, simdMatchesScalar)
+{
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> distribution(-1000, 1000);
+
+    constexpr int input_size = 64;
+    constexpr int output_size = nnue::HIDDEN_DIMENSIONS;
+    std::vector<int16_t> input(input_size), weights(input_size * output_size);
+    std::vector<int32_t> bias(output_size);
+    for (int16_t& x : input) x = static_cast<int16_t>(distribution(rng) % 128);
+    for (int16_t& x : weights) x = static_cast<int16_t>(distribution(rng));
+    for (int32_t& x : bias) x = distribution(rng);
+
+    std::vector<int32_t> output(output_size), expected(output_size);
+    nnue::affine(input.data(), input_size, weights.data(), bias.data(), output.data(), output_size);
+    nnue::affine_scalar(input.data(), input_size, weights.data(), bias.data(), expected.data(), output_size);
+    EXPECT_EQ(output, expected);
+
+    std::vector<int16_t> values(input), expected_values(input);
+    nnue::add_row(values.data(), weights.data(), input_size);
+    nnue::add_row_scalar(expected_values.data(), weights.data(), input_size);
+    EXPECT_EQ(values, expected_values);
+    nnue::sub_row(values.data(), weights.data() + input_size, input_size);
+    nnue::sub_row_scalar(expected_values.data(), weights.data() + input_size, input_size);
+    EXPECT_EQ(values, expected_values);
+}
+
+}  // namespace
@@ -2,8 +2,13 @@
 #include <gtest/gtest.h>
 
 #include "bitboard.h"
+#include "movegen.h"
 #include "position.h"
 #include "score.h"
+#include "zobrist_hash.h"
+
+#include <algorithm>
+#include <random>
 
 using namespace engine;
 
@@ -140,35 +145,98 @@ TEST(PositionTest, fen)
 
 TEST(PositionTest, do_move)
 {
-    using TestCase = std::tuple<std::string, Move, MoveInfo, std::string>;
+    using TestCase = std::tuple<std::string, Move, Piece, std::string>;
 
     std::vector<TestCase> test_cases = {
         {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
          create_move(SQ_E2, SQ_E4),
-         create_moveinfo(NO_PIECE_KIND, ALL_CASTLING, NO_SQUARE, false, 0),
+         NO_PIECE,
          "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1",
         },
         {"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1",
          create_move(SQ_G8, SQ_F6),
-         create_moveinfo(NO_PIECE_KIND, ALL_CASTLING, SQ_E3, false, 0),
+         NO_PIECE,
          "rnbqkb1r/pppppppp/5n2/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 1 2",
         },
         {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
          create_move(SQ_E5, SQ_G6),
-         create_moveinfo(PAWN, ALL_CASTLING, NO_SQUARE, false, 0),
+         B_PAWN,
          "r3k2r/p1ppqpb1/bn2pnN1/3P4/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq - 0 1"
         },
+        {"8/8/3k4/8/2pP4/8/8/4K3 b - d3 0 1",
+         create_move(SQ_C4, SQ_D3),
+         W_PAWN,
+         "8/8/3k4/8/8/3p4/8/4K3 w - - 0 2"
+        },
     };
 
     for (const TestCase& test_case : test_cases)
     {
         Position position(std::get<0>(test_case));
-        MoveInfo moveinfo = position.do_move(std::get<1>(test_case));
-        EXPECT_EQ(moveinfo, std::get<2>(test_case));
+        position.do_move(std::get<1>(test_case));
+        EXPECT_EQ(position.captured_piece(), std::get<2>(test_case));
         EXPECT_EQ(position.fen(), std::get<3>(test_case));
     }
 }
 
+TEST(PositionTest, stateStack)
+{
+    // check info and all restored state has to match freshly set up positions
+    std::mt19937 rng(1234);
+    for (const std::string& fen : {Position::STARTPOS_FEN,
+                                  std::string("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"),
+                                  std::string("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1")})
+    {
+        Position position(fen);
+        std::vector<Move> played;
+        std::vector<std::string> fens = {position.fen()};
+
+        for (int ply = 0; ply < 100; ++ply)
+        {
+            Move moves[MAX_MOVES];
+            Move* end = generate_moves(position, position.color(), moves);
+            if (end == moves) break;
+
+            const Move move = moves[rng() % (end - moves)];
+            position.do_move(move);
+            played.push_back(move);
+            fens.push_back(position.fen());
+
+            const Position fresh(position.fen());
+            ASSERT_EQ(position.hash(), fresh.hash()) << position.fen();
+            ASSERT_EQ(position.pawn_hash(), fresh.pawn_hash()) << position.fen();
+            ASSERT_EQ(position.material_hash(), fresh.material_hash()) << position.fen();
+            ASSERT_EQ(position.material_hash(), zobrist::material_key(position.get_pcv()))
+                << position.fen();
+            ASSERT_EQ(position.checkers(), fresh.checkers()) << position.fen();
+            ASSERT_EQ(position.pinned(), fresh.pinned()) << position.fen();
+            ASSERT_EQ(position.psq_score().mg, fresh.psq_score().mg) << position.fen();
+            ASSERT_EQ(position.psq_score().eg, fresh.psq_score().eg) << position.fen();
+        }
+
+        while (!played.empty())
+        {
+            position.undo_move(played.back());
+            played.pop_back();
+            fens.pop_back();
+            ASSERT_EQ(position.fen(), fens.back());
+            ASSERT_EQ(position.hash(), Position(fens.back()).hash());
+        }
+    }
+
+    // pinned pieces and checkers
+    Position position("4k3/8/8/1b6/8/3N4/4R3/r3K2q w - - 0 1");
+    EXPECT_EQ(position.checkers(), square_bb(SQ_A1) | square_bb(SQ_H1));
+    EXPECT_EQ(position.pinned(), no_squares_bb);
+    position = Position("4k3/4r3/8/1b6/8/3N4/4R3/4K3 w - - 0 1");
+    EXPECT_EQ(position.checkers(), no_squares_bb);
+    EXPECT_EQ(position.pinned(), square_bb(SQ_E2));
+    position = Position("4k3/8/8/1b6/8/3N4/8/5K2 w - - 0 1");
+    EXPECT_EQ(position.pinned(), square_bb(SQ_D3));
+    position = Position("4k3/8/8/1b6/2P5/3N4/8/5K2 w - - 0 1");
+    EXPECT_EQ(position.pinned(), no_squares_bb);
+}
+
 TEST(PositionTest, threefold_repetition)
 {
     using TestCase = std::tuple<std::vector<std::string>, bool>;
@@ -185,6 +253,65 @@ TEST(PositionTest, threefold_repetition)
     }
 }
 
+TEST(PositionTest, upcomingRepetition)
+{
+    // every reversible move has its own entry
+    EXPECT_EQ(std::count_if(zobrist::CUCKOO_MOVES, zobrist::CUCKOO_MOVES + zobrist::CUCKOO_SIZE,
+                            [](Move move) { return move != NO_MOVE; }),
+              3668);
+
+    using TestCase = std::tuple<std::string, std::vector<std::string>, bool>;
+    std::vector<TestCase> test_cases = {
+        {Position::STARTPOS_FEN, {"g1f3", "g8f6"}, false},
+        // black can go back to the starting position
+        {Position::STARTPOS_FEN, {"g1f3", "g8f6", "f3g1"}, true},
+        // pawn move in between
+        {Position::STARTPOS_FEN, {"g1f3", "e7e6", "f3g1"}, false},
+        // only black knight can go back
+        {Position::STARTPOS_FEN, {"g1f3", "g8f6", "f3g1", "f6g4", "g1f3", "g4h6"}, false},
+        {"4k3/8/8/8/8/8/8/R3K3 w - - 0 1", {"a1a4", "e8d8", "e1e2", "d8e8"}, true},
+    };
+
+    for (const TestCase& test_case : test_cases)
+    {
+        Position position(std::get<0>(test_case));
+        for (const std::string& move : std::get<1>(test_case))
+            position.do_move(position.parse_uci(move));
+        EXPECT_EQ(position.has_upcoming_repetition(), std::get<2>(test_case)) << position.fen();
+    }
+}
+
+TEST(PositionTest, gameHistory)
+{
+    Position position;
+    for (const char* move : {"e2e4", "e7e5", "g1f3", "g8f6", "f3g1", "f6g8", "g1f3", "g8f6", "f3g1"})
+        position.do_move(position.parse_uci(move));
+
+    // copy has its own history but still sees repetitions
+    Position copy = position;
+    EXPECT_TRUE(copy.is_repeated());
+    const Move first = copy.parse_uci("f6g8");
+    copy.do_move(first);
+    const Move second = copy.parse_uci("g1f3");
+    copy.do_move(second);
+    EXPECT_TRUE(copy.threefold_repetition());
+    EXPECT_FALSE(position.threefold_repetition());
+    copy.undo_move(second);
+    copy.undo_move(first);
+    EXPECT_EQ(copy, position);
+
+    // history grows beyond any fixed number of plies
+    const std::string fen = position.fen();
+    const Move moves[] = {position.parse_uci("g1f3"), position.parse_uci("f6g8"),
+                          position.parse_uci("f3g1"), position.parse_uci("g8f6")};
+    for (int ply = 0; ply < 2000; ++ply)
+        position.do_move(moves[ply % 4]);
+    EXPECT_EQ(position.fen().substr(0, fen.find(' ')), fen.substr(0, fen.find(' ')));
+    for (int ply = 2000 - 1; ply >= 0; --ply)
+        position.undo_move(moves[ply % 4]);
+    EXPECT_EQ(position.fen(), fen);
+}
+
 TEST(PositionTest, parse_san)
 {
     using TestCase = std::tuple<std::string, std::string, Move>;
@@ -326,8 +453,8 @@ TEST(PositionTest, hash)
         uint64_t hash = position.hash();
         uint64_t pawn_hash = position.pawn_hash();
 
-        MoveInfo moveinfo = position.do_move(std::get<1>(test_case));
-        position.undo_move(std::get<1>(test_case), moveinfo);
+        position.do_move(std::get<1>(test_case));
+        position.undo_move(std::get<1>(test_case));
 
         EXPECT_EQ(hash, position.hash());
         EXPECT_EQ(pawn_hash, position.pawn_hash());
@@ -499,6 +626,34 @@ TEST(PositionTest, move_types)
     }
 }
 
+TEST(PositionTest, see)
+{
+    const Value P = PIECE_VALUE[PAWN].mg;
+    const Value R = PIECE_VALUE[ROOK].mg;
+    const Value Q = PIECE_VALUE[QUEEN].mg;
+
+    // fen, move, expected see
+    using TestCase = std::tuple<std::string, Move, Value>;
+
+    std::vector<TestCase> test_cases = {
+        {"4k3/8/8/3p4/4P3/8/8/4K3 w - - 0 1", create_move(SQ_E4, SQ_D5), P},
+        {"4k3/8/2p5/3p4/4P3/8/8/4K3 w - - 0 1", create_move(SQ_E4, SQ_D5), 0},
+        {"4k3/8/2p5/3p4/8/8/3Q4/4K3 w - - 0 1", create_move(SQ_D2, SQ_D5), P - Q},
+        {"3rk3/8/8/3p4/8/8/3R4/3RK3 w - - 0 1", create_move(SQ_D2, SQ_D5), P},
+        {"3rk3/3r4/8/3p4/8/8/3R4/3RK3 w - - 0 1", create_move(SQ_D2, SQ_D5), P - R},
+        {"4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", create_move(SQ_E5, SQ_D6), P},
+        {"4k3/P7/8/8/8/8/8/4K3 w - - 0 1", create_promotion(SQ_A7, SQ_A8, QUEEN), Q - P},
+        {"1k6/P7/8/8/8/8/8/4K3 w - - 0 1", create_promotion(SQ_A7, SQ_A8, QUEEN), -P},
+        {"4k3/8/8/8/8/8/8/R3K2R w KQ - 0 1", KING_CASTLING_MOVE, 0},
+    };
+
+    for (const TestCase& test_case : test_cases)
+    {
+        Position position(std::get<0>(test_case));
+        EXPECT_EQ(position.see(std::get<1>(test_case)), std::get<2>(test_case)) << std::get<0>(test_case);
+    }
+}
+
 /* TEST(ScoreTest, knight) */
 /* { */
 /*     Position position("rnbqkb1r/pp2pppp/2p5/3pP3/4n3/2N2N2/PPPP1PPP/R1BQKB1R w - -"); */
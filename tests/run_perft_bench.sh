@@ -0,0 +1,46 @@
+#!/bin/bash
+
+# Measures perft speed of given engine builds, e.g. to compare slider
+# attack backends:
+#   ./tests/run_perft_bench.sh build/chessplusplus build-pext/chessplusplus
+
+trap "{ exit 255; }" INT
+
+PROGRAMS=("$@")
+if [ ${#PROGRAMS[@]} -eq 0 ]
+then
+    PROGRAMS=("./build/chessplusplus")
+fi
+
+POSITIONS=(
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1;6"
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1;5"
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1;7"
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1;5"
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8;5"
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10;5"
+)
+
+for program in "${PROGRAMS[@]}"
+do
+    total_nodes=0
+    total_time=0
+    backend=""
+
+    for position in "${POSITIONS[@]}"
+    do
+        fen=${position%;*}
+        depth=${position##*;}
+
+        output=$(printf "position fen %s\nperft %s\nquit\n" "${fen}" "${depth}" | ${program})
+        nodes=$(echo "${output}" | sed -n 's/^Number of nodes: \([0-9]*\)$/\1/p')
+        time=$(echo "${output}" | sed -n 's/^Time: \([0-9]*\)ms$/\1/p')
+        backend=$(echo "${output}" | sed -n 's/^Slider attacks: \(.*\)$/\1/p')
+
+        total_nodes=$((total_nodes + nodes))
+        total_time=$((total_time + time))
+    done
+
+    echo "${program} (${backend}): nodes ${total_nodes} time ${total_time}ms" \
+         "speed $((total_nodes * 1000 / (total_time + 1)))nps"
+done
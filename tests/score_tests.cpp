@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include "movegen.h"
+#include "position.h"
+#include "score.h"
+
+#include <random>
+
+using namespace engine;
+
+namespace
+{
+
+TEST(EvalCacheTest, storeAndProbe)
+{
+    EvalCache cache;
+    cache.resize(1);
+    EXPECT_EQ(cache.size_mb(), 1ULL);
+
+    const uint64_t key = 0x123456789abcdef0ULL;
+    Value value = 0;
+    EXPECT_FALSE(cache.probe(key, value));
+
+    for (Value stored : {Value(0), Value(-1), Value(1234), -VALUE_KNOWN_WIN})
+    {
+        cache.store(key, stored);
+        ASSERT_TRUE(cache.probe(key, value));
+        EXPECT_EQ(value, stored);
+    }
+
+    // same slot, different key
+    EXPECT_FALSE(cache.probe(key ^ 0x1000000000000000ULL, value));
+    EXPECT_EQ(cache.stats().probes, 6ULL);
+    EXPECT_EQ(cache.stats().hits, 4ULL);
+
+    cache.clear();
+    EXPECT_FALSE(cache.probe(key, value));
+
+    // disabled cache never hits
+    cache.resize(0);
+    cache.store(key, 1);
+    EXPECT_FALSE(cache.probe(key, value));
+}
+
+TEST(EvalCacheTest, cachedScoreMatchesEvaluation)
+{
+    PositionScorer cached;
+    PositionScorer uncached;
+    uncached.eval_cache().resize(0);
+
+    std::mt19937 rng(1234);
+    for (int game = 0; game < 20; ++game)
+    {
+        Position position;
+        for (int ply = 0; ply < 60; ++ply)
+        {
+            Move moves[MAX_MOVES];
+            Move* end = generate_moves(position, position.color(), moves);
+            if (end == moves) break;
+
+            position.do_move(moves[rng() % (end - moves)]);
+            EXPECT_EQ(cached.score(position), uncached.score(position)) << position.fen();
+            EXPECT_EQ(cached.score(position), uncached.score(position)) << position.fen();
+        }
+    }
+
+    EXPECT_GT(cached.eval_cache().stats().hits, 0ULL);
+}
+
+}  // namespace
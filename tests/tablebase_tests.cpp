@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include "endgame.h"
+#include "position.h"
+#include "tablebase.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace engine;
+
+namespace
+{
+
+std::string fen_of(Color side, Square white_king, Square white_pawn, Square black_king)
+{
+    std::string board[RANK_NUM];
+    for (Rank r = RANK_1; r <= RANK_8; ++r)
+    {
+        for (File f = FILE_A; f <= FILE_H; ++f)
+        {
+            const Square square = make_square(r, f);
+            board[r] += square == white_king ? 'K' : square == white_pawn ? 'P' : square == black_king ? 'k' : '1';
+        }
+    }
+
+    std::string fen;
+    for (int r = RANK_8; r >= RANK_1; --r) fen += board[r] + (r == RANK_1 ? " " : "/");
+    return fen + (side == WHITE ? "w" : "b") + " - - 0 1";
+}
+
+class TablebaseTest : public ::testing::Test
+{
+  protected:
+    static void SetUpTestSuite()
+    {
+        directory = std::filesystem::temp_directory_path() / "chessplusplus_tb_test";
+        std::filesystem::create_directories(directory);
+        std::ostringstream log;
+        ASSERT_EQ(tablebase::generate(directory.string(), 3, log), 5);
+    }
+
+    static void TearDownTestSuite()
+    {
+        tablebase::release();
+        std::filesystem::remove_all(directory);
+    }
+
+    static tablebase::WdlScore probe(const std::string& fen)
+    {
+        tablebase::WdlScore score = tablebase::kDRAW;
+        EXPECT_TRUE(tablebase::probe_wdl(Position(fen), score)) << fen;
+        return score;
+    }
+
+    static std::filesystem::path directory;
+};
+
+std::filesystem::path TablebaseTest::directory;
+
+TEST_F(TablebaseTest, matchesKPKBitbase)
+{
+    for (Color side : {WHITE, BLACK})
+    for (Square white_king = SQ_A1; white_king <= SQ_H8; ++white_king)
+    for (Square black_king = SQ_A1; black_king <= SQ_H8; ++black_king)
+    for (Square white_pawn = SQ_A2; white_pawn <= SQ_H7; ++white_pawn)
+    {
+        if (file(white_pawn) > FILE_D || distance(white_king, black_king) <= 1 ||
+            white_pawn == white_king || white_pawn == black_king)
+            continue;
+        // side which is not to move can't be in check
+        if (side == WHITE && (pawn_attacks<WHITE>(square_bb(white_pawn)) & square_bb(black_king)))
+            continue;
+
+        Position position(fen_of(side, white_king, white_pawn, black_king));
+        tablebase::WdlScore score;
+        ASSERT_TRUE(tablebase::probe_wdl(position, score));
+
+        const bool win = bitbase::check(side, white_king, white_pawn, black_king);
+        const tablebase::WdlScore expected =
+            !win ? tablebase::kDRAW : side == WHITE ? tablebase::kWIN : tablebase::kLOSS;
+        ASSERT_EQ(score, expected) << position.fen();
+    }
+}
+
+TEST_F(TablebaseTest, probe)
+{
+    EXPECT_EQ(probe("8/8/4k3/8/8/8/3QK3/8 w - - 0 1"), tablebase::kWIN);
+    EXPECT_EQ(probe("8/8/4k3/8/8/8/3QK3/8 b - - 0 1"), tablebase::kLOSS);
+    // colors are swapped for tables with stronger black
+    EXPECT_EQ(probe("8/8/4K3/8/8/8/3qk3/8 b - - 0 1"), tablebase::kWIN);
+    EXPECT_EQ(probe("8/8/4K3/8/8/8/3rk3/8 w - - 0 1"), tablebase::kLOSS);
+    // rook can be captured
+    EXPECT_EQ(probe("8/8/8/8/8/8/3rk3/3K4 w - - 0 1"), tablebase::kDRAW);
+    // stalemate
+    EXPECT_EQ(probe("k7/8/1Q6/8/8/8/8/7K b - - 0 1"), tablebase::kDRAW);
+    EXPECT_EQ(probe("8/8/4k3/8/8/8/3BK3/8 w - - 0 1"), tablebase::kDRAW);
+    EXPECT_EQ(probe("8/8/4k3/8/8/8/3NK3/8 b - - 0 1"), tablebase::kDRAW);
+    // rook pawn with the king in front of it
+    EXPECT_EQ(probe("k7/8/8/8/P7/8/8/7K w - - 0 1"), tablebase::kDRAW);
+
+    tablebase::WdlScore score;
+    // too many pieces, castling rights or en passant
+    EXPECT_FALSE(tablebase::probe_wdl(Position("8/8/4k3/8/8/8/3QKR2/8 w - - 0 1"), score));
+    EXPECT_FALSE(tablebase::probe_wdl(Position("4k3/8/8/8/8/8/8/R3K3 w Q - 0 1"), score));
+    EXPECT_FALSE(tablebase::probe_wdl(Position("4k3/8/8/8/4P3/8/8/4K3 b - e3 0 1"), score));
+}
+
+TEST_F(TablebaseTest, loadFromFiles)
+{
+    const std::string fen = "8/8/8/3k4/8/8/3RK3/8 b - - 0 1";
+    const tablebase::WdlScore generated = probe(fen);
+
+    tablebase::release();
+    tablebase::WdlScore score;
+    EXPECT_FALSE(tablebase::probe_wdl(Position(fen), score));
+    EXPECT_EQ(tablebase::max_pieces(), 0);
+
+    // invalid files are skipped
+    {
+        std::ofstream stream(directory / "KQQvK.cpptb", std::ios::binary | std::ios::trunc);
+        stream << "not a tablebase";
+    }
+    EXPECT_EQ(tablebase::init(directory.string()), 5);
+    EXPECT_EQ(tablebase::max_pieces(), 3);
+    EXPECT_EQ(probe(fen), generated);
+    std::filesystem::remove(directory / "KQQvK.cpptb");
+}
+
+// generates 4 piece tables (without pawns, so they
+// don't depend on other 4 piece tables)
+class FourPieceTablebaseTest : public TablebaseTest
+{
+  protected:
+    static void SetUpTestSuite()
+    {
+        generate({create_pcv(0, 0, 2, 0, 0, 0, 0, 0, 0, 0),    // KBBvK
+                  create_pcv(0, 0, 0, 0, 1, 0, 0, 0, 1, 0)},  // KQvKR
+                 5);
+    }
+
+    static void generate(const std::vector<PieceCountVector>& materials, int expected)
+    {
+        directory = std::filesystem::temp_directory_path() / "chessplusplus_tb4_test";
+        std::filesystem::create_directories(directory);
+        std::ostringstream log;
+        ASSERT_EQ(tablebase::generate_with_dependencies(directory.string(), materials, log),
+                  expected);
+    }
+};
+
+TEST_F(FourPieceTablebaseTest, probe)
+{
+    EXPECT_EQ(tablebase::max_pieces(), 4);
+
+    // bishops on squares of the same color can't mate
+    EXPECT_EQ(probe("4k3/8/8/8/8/4B3/8/2B1K3 w - - 0 1"), tablebase::kDRAW);
+    EXPECT_EQ(probe("4k3/8/8/8/8/8/8/2B1KB2 w - - 0 1"), tablebase::kWIN);
+    EXPECT_EQ(probe("4k3/8/8/8/8/8/8/2B1KB2 b - - 0 1"), tablebase::kLOSS);
+
+    EXPECT_EQ(probe("2k5/8/8/8/8/8/6r1/3QK3 w - - 0 1"), tablebase::kWIN);
+    // skewer after Rg1+ Ke2 wins the queen
+    EXPECT_EQ(probe("2k5/8/8/8/8/8/6r1/3QK3 b - - 0 1"), tablebase::kDRAW);
+}
+
+// Pawns can promote to every 4 piece table with two pieces, generating
+// them takes minutes, so tests are disabled by default and run only
+// by the slowUnitTests ctest.
+class PawnTablebaseTest : public FourPieceTablebaseTest
+{
+  protected:
+    static void SetUpTestSuite()
+    {
+        generate({create_pcv(0, 0, 0, 0, 0, 2, 0, 0, 0, 0)}, 20);  // KvKPP
+    }
+};
+
+TEST_F(PawnTablebaseTest, DISABLED_probe)
+{
+    EXPECT_EQ(probe("4k3/8/8/8/8/8/PP6/4K3 w - - 0 1"), tablebase::kWIN);
+    EXPECT_EQ(probe("4k3/pp6/8/8/8/8/8/4K3 b - - 0 1"), tablebase::kWIN);
+    EXPECT_EQ(probe("4k3/pp6/8/8/8/8/8/4K3 w - - 0 1"), tablebase::kLOSS);
+    // pawn promotes to a piece from another 4 piece table
+    EXPECT_EQ(probe("4k3/1P6/8/8/8/8/P7/4K3 w - - 0 1"), tablebase::kWIN);
+
+    // two knights can't force mate, but mate is possible
+    EXPECT_EQ(probe("4k3/8/8/8/8/8/8/1N2KN2 w - - 0 1"), tablebase::kDRAW);
+    EXPECT_EQ(probe("7k/5N2/6KN/8/8/8/8/8 b - - 0 1"), tablebase::kLOSS);
+}
+
+}  // namespace
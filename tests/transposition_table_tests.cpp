@@ -0,0 +1,381 @@
+#include <gtest/gtest.h>
+
+#include "movegen.h"
+#include "transposition_table.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+
+using namespace engine;
+
+namespace
+{
+
+// keys sharing the lower bits map to the same cluster
+uint64_t cluster_key(uint64_t n)
+{
+    return (n << 48) | 0x1234ULL;
+}
+
+TEST(TranspositionTableTest, probeAfterInsert)
+{
+    tt::TTable ttable(1);
+    const Move move = create_move(SQ_E2, SQ_E4);
+    ttable.insert(cluster_key(1), tt::TTEntry(123, 7, tt::Flag::kLOWER_BOUND, move));
+
+    bool found = false;
+    tt::TTable::Entry entry = ttable.probe(cluster_key(1), found);
+    ASSERT_TRUE(found);
+    EXPECT_EQ(entry.score(), 123);
+    EXPECT_EQ(entry.depth(), 7);
+    EXPECT_EQ(entry.flag(), tt::Flag::kLOWER_BOUND);
+    EXPECT_EQ(entry.move(), move);
+    EXPECT_EQ(entry.eval(), VALUE_NONE);
+    EXPECT_TRUE(ttable.isCurrentEpoch(entry.epoch()));
+
+    ttable.probe(cluster_key(2), found);
+    EXPECT_FALSE(found);
+
+    ttable.clear();
+    ttable.probe(cluster_key(1), found);
+    EXPECT_FALSE(found);
+}
+
+TEST(TranspositionTableTest, parallelClear)
+{
+    tt::TTable ttable(3, 4);
+    for (uint64_t i = 0; i < (1 << 16); ++i)
+        ttable.insert(i * 0x9E3779B97F4A7C15ULL, tt::TTEntry(0, 1, tt::Flag::kEXACT, NO_MOVE));
+    EXPECT_GT(ttable.hashfull(), 0);
+
+    ttable.clear(4);
+    EXPECT_EQ(ttable.hashfull(), 0);
+    for (uint64_t i = 0; i < (1 << 16); ++i)
+    {
+        bool found = false;
+        ttable.probe(i * 0x9E3779B97F4A7C15ULL, found);
+        EXPECT_FALSE(found);
+    }
+}
+
+TEST(TranspositionTableTest, replacesShallowestEntry)
+{
+    tt::TTable ttable(1);
+    // second entry is the shallowest one
+    for (uint64_t i = 0; i < tt::TTable::CLUSTER_SIZE; ++i)
+        ttable.insert(cluster_key(i + 1),
+                      tt::TTEntry(0, i == 1 ? 3 : 10 + i, tt::Flag::kUPPER_BOUND, NO_MOVE));
+
+    bool found = false;
+    for (uint64_t i = 0; i < tt::TTable::CLUSTER_SIZE; ++i)
+    {
+        ttable.probe(cluster_key(i + 1), found);
+        EXPECT_TRUE(found);
+    }
+
+    ttable.insert(cluster_key(10), tt::TTEntry(0, 5, tt::Flag::kUPPER_BOUND, NO_MOVE));
+    ttable.probe(cluster_key(10), found);
+    EXPECT_TRUE(found);
+    for (uint64_t i = 0; i < tt::TTable::CLUSTER_SIZE; ++i)
+    {
+        ttable.probe(cluster_key(i + 1), found);
+        EXPECT_EQ(found, i != 1);
+    }
+}
+
+TEST(TranspositionTableTest, prefersReplacingOldEntries)
+{
+    tt::TTable ttable(1);
+    ttable.insert(cluster_key(1), tt::TTEntry(0, 20, tt::Flag::kEXACT, NO_MOVE));
+    ttable.updateEpoch(4);
+    for (uint64_t i = 2; i <= tt::TTable::CLUSTER_SIZE; ++i)
+        ttable.insert(cluster_key(i), tt::TTEntry(0, 2, tt::Flag::kUPPER_BOUND, NO_MOVE));
+
+    ttable.insert(cluster_key(10), tt::TTEntry(0, 1, tt::Flag::kUPPER_BOUND, NO_MOVE));
+
+    bool found = false;
+    ttable.probe(cluster_key(1), found);
+    EXPECT_FALSE(found);
+    for (uint64_t i = 2; i <= tt::TTable::CLUSTER_SIZE; ++i)
+    {
+        ttable.probe(cluster_key(i), found);
+        EXPECT_TRUE(found);
+    }
+}
+
+TEST(TranspositionTableTest, keepsDeeperResultForSamePosition)
+{
+    tt::TTable ttable(1);
+    ttable.insert(cluster_key(1), tt::TTEntry(50, 12, tt::Flag::kLOWER_BOUND, NO_MOVE));
+    ttable.insert(cluster_key(1), tt::TTEntry(10, 2, tt::Flag::kUPPER_BOUND, NO_MOVE));
+
+    bool found = false;
+    tt::TTable::Entry entry = ttable.probe(cluster_key(1), found);
+    ASSERT_TRUE(found);
+    EXPECT_EQ(entry.depth(), 12);
+    EXPECT_EQ(entry.score(), 50);
+
+    ttable.insert(cluster_key(1), tt::TTEntry(30, 2, tt::Flag::kEXACT, NO_MOVE));
+    entry = ttable.probe(cluster_key(1), found);
+    ASSERT_TRUE(found);
+    EXPECT_EQ(entry.depth(), 2);
+    EXPECT_EQ(entry.score(), 30);
+}
+
+TEST(TranspositionTableTest, packValue)
+{
+    EXPECT_EQ(tt::unpack_value(tt::pack_value(VALUE_NONE)), VALUE_NONE);
+
+    for (Value value = -16383; value <= 16383; ++value)
+        EXPECT_EQ(tt::unpack_value(tt::pack_value(value)), value);
+
+    for (int ply = 0; ply <= 2 * MAX_DEPTH; ++ply)
+    {
+        EXPECT_EQ(tt::unpack_value(tt::pack_value(win_in(ply))), win_in(ply));
+        EXPECT_EQ(tt::unpack_value(tt::pack_value(lost_in(ply))), lost_in(ply));
+    }
+
+    // known wins keep their order and stay close to the original value
+    Value previous = tt::unpack_value(tt::pack_value(VALUE_KNOWN_WIN));
+    EXPECT_LE(std::abs(previous - VALUE_KNOWN_WIN), 64);
+    for (Value value = VALUE_KNOWN_WIN; value < win_in(2 * MAX_DEPTH); value += 17)
+    {
+        const Value unpacked = tt::unpack_value(tt::pack_value(value));
+        EXPECT_LE(std::abs(unpacked - value), 64);
+        EXPECT_GE(unpacked, previous);
+        EXPECT_FALSE(is_mate(unpacked));
+        EXPECT_EQ(tt::unpack_value(tt::pack_value(-value)), -unpacked);
+        previous = unpacked;
+    }
+}
+
+TEST(TranspositionTableTest, packValueKeepsBounds)
+{
+    for (Value value = -VALUE_MATE; value <= VALUE_MATE; value += 13)
+    {
+        const Value lower = tt::unpack_value(tt::pack_value(value, tt::Flag::kLOWER_BOUND));
+        const Value upper = tt::unpack_value(tt::pack_value(value, tt::Flag::kUPPER_BOUND));
+        const Value exact = tt::unpack_value(tt::pack_value(value, tt::Flag::kEXACT));
+
+        ASSERT_LE(lower, value);
+        ASSERT_GE(upper, value);
+        ASSERT_LE(std::abs(exact), std::abs(value));
+        ASSERT_GE(exact * value, 0);
+        ASSERT_LE(upper - lower, 64) << value;
+    }
+
+    // tablebase wins and known wins with small progress terms are exact
+    for (tt::Flag flag : {tt::Flag::kEXACT, tt::Flag::kLOWER_BOUND, tt::Flag::kUPPER_BOUND})
+    {
+        for (int ply = 0; ply <= 2 * MAX_DEPTH; ++ply)
+        {
+            EXPECT_EQ(tt::unpack_value(tt::pack_value(tb_win_in(ply), flag)), tb_win_in(ply));
+            EXPECT_EQ(tt::unpack_value(tt::pack_value(tb_lost_in(ply), flag)), tb_lost_in(ply));
+        }
+        for (Value value = VALUE_KNOWN_WIN; value < VALUE_KNOWN_WIN + 4096; ++value)
+        {
+            EXPECT_EQ(tt::unpack_value(tt::pack_value(value, flag)), value);
+            EXPECT_EQ(tt::unpack_value(tt::pack_value(-value, flag)), -value);
+        }
+    }
+
+    tt::TTable ttable(1);
+    const Value value = VALUE_KNOWN_WIN + 10001;
+    ttable.insert(cluster_key(1), tt::TTEntry(value, 3, tt::Flag::kUPPER_BOUND, NO_MOVE));
+    ttable.insert(cluster_key(2), tt::TTEntry(-value, 3, tt::Flag::kLOWER_BOUND, NO_MOVE));
+    bool found = false;
+    EXPECT_GE(ttable.probe(cluster_key(1), found).score(), value);
+    EXPECT_LE(ttable.probe(cluster_key(2), found).score(), -value);
+}
+
+TEST(TranspositionTableTest, storesStaticEval)
+{
+    tt::TTable ttable(1);
+    ttable.insert(cluster_key(1), tt::TTEntry(-250, 3, tt::Flag::kUPPER_BOUND,
+                                              QUEEN_CASTLING_MOVE, 123));
+
+    bool found = false;
+    tt::TTable::Entry entry = ttable.probe(cluster_key(1), found);
+    ASSERT_TRUE(found);
+    EXPECT_EQ(entry.score(), -250);
+    EXPECT_EQ(entry.eval(), 123);
+    EXPECT_EQ(entry.move(), QUEEN_CASTLING_MOVE);
+}
+
+TEST(TranspositionTableTest, resize)
+{
+    tt::TTable ttable(1);
+    EXPECT_EQ(ttable.size_mb(), 1);
+    ttable.insert(cluster_key(1), tt::TTEntry(0, 1, tt::Flag::kEXACT, NO_MOVE));
+
+    // resizing to the same size keeps the content
+    bool found = false;
+    ttable.resize(1);
+    ttable.probe(cluster_key(1), found);
+    EXPECT_TRUE(found);
+
+    ttable.resize(3);
+    EXPECT_EQ(ttable.size_mb(), 3);
+    ttable.probe(cluster_key(1), found);
+    EXPECT_FALSE(found);
+
+    // table size doesn't have to be a power of 2
+    for (uint64_t i = 0; i < (1 << 16); ++i)
+    {
+        const uint64_t key = i * 0x9E3779B97F4A7C15ULL;
+        ttable.insert(key, tt::TTEntry(0, 1, tt::Flag::kEXACT, NO_MOVE));
+        ttable.probe(key, found);
+        EXPECT_TRUE(found);
+    }
+}
+
+TEST(TranspositionTableTest, concurrentProbeAndInsert)
+{
+    Position position(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - ");
+    Move moves[MAX_MOVES];
+    Move* end = generate_moves(position, position.color(), moves);
+    const int n_moves = static_cast<int>(end - moves);
+
+    // all fields of stored entry are derived from the move index,
+    // so mixing data from different writes can be detected
+    auto make_entry = [&moves](int move_index, int32_t depth) {
+        const Value score = 100 * depth + move_index;
+        return tt::TTEntry(score, depth, tt::Flag::kLOWER_BOUND,
+                           moves[move_index], -score);
+    };
+
+    // small table and few clusters, so that threads keep hitting same entries
+    tt::TTable ttable(1);
+    const int n_threads = 8;
+    const int n_iterations = 200000;
+
+    std::atomic<int> n_corrupted = 0;
+    std::atomic<int> n_found = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            std::mt19937_64 rng(t);
+            for (int i = 0; i < n_iterations; ++i)
+            {
+                const uint64_t key = (rng() & 0xFFFFFFFF00000000ULL) | (rng() % 4);
+                if (rng() % 2 == 0)
+                {
+                    ttable.insert(key, make_entry(static_cast<int>(rng() % n_moves),
+                                                  static_cast<int32_t>(1 + rng() % MAX_DEPTH)));
+                    continue;
+                }
+
+                bool found = false;
+                const tt::TTable::Entry entry = ttable.probe(key, found);
+                if (!found) continue;
+                n_found++;
+
+                const Move* it = std::find(moves, end, entry.move());
+                const int move_index = static_cast<int>(it - moves);
+                if (it == end ||
+                    entry.score() != 100 * entry.depth() + move_index ||
+                    entry.eval() != -entry.score() ||
+                    entry.flag() != tt::Flag::kLOWER_BOUND)
+                    n_corrupted++;
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    EXPECT_GT(n_found, 0);
+    EXPECT_EQ(n_corrupted, 0);
+}
+
+TEST(TranspositionTableTest, saveAndLoad)
+{
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "chessplusplus_tt_test.bin").string();
+
+    tt::TTable ttable(2);
+    ttable.updateEpoch(5);
+    for (uint64_t i = 0; i < (1 << 12); ++i)
+        ttable.insert(i * 0x9E3779B97F4A7C15ULL,
+                      tt::TTEntry(Value(i), 1 + i % 20, tt::Flag::kLOWER_BOUND,
+                                  create_move(SQ_A2, SQ_A4), -Value(i)));
+    ASSERT_TRUE(ttable.save(path));
+
+    tt::TTable loaded(1);
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_EQ(loaded.size_mb(), 2);
+    EXPECT_EQ(loaded.hashfull(), ttable.hashfull());
+    for (uint64_t i = 0; i < (1 << 12); ++i)
+    {
+        bool found = false, loaded_found = false;
+        const tt::TTable::Entry entry = ttable.probe(i * 0x9E3779B97F4A7C15ULL, found);
+        const tt::TTable::Entry loaded_entry = loaded.probe(i * 0x9E3779B97F4A7C15ULL, loaded_found);
+        ASSERT_EQ(found, loaded_found);
+        if (!found) continue;
+        EXPECT_EQ(entry.score(), loaded_entry.score());
+        EXPECT_EQ(entry.eval(), loaded_entry.eval());
+        EXPECT_EQ(entry.depth(), loaded_entry.depth());
+        EXPECT_EQ(entry.move(), loaded_entry.move());
+        EXPECT_TRUE(loaded.isCurrentEpoch(loaded_entry.epoch()));
+    }
+
+    // loaded table is writable and can be resized
+    loaded.insert(1, tt::TTEntry(7, 3, tt::Flag::kEXACT, NO_MOVE));
+    bool found = false;
+    EXPECT_EQ(loaded.probe(1, found).score(), 7);
+    EXPECT_TRUE(found);
+    loaded.resize(1);
+    EXPECT_EQ(loaded.size_mb(), 1);
+
+    // broken file is rejected and table is kept
+    {
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        stream << "not a transposition table";
+    }
+    EXPECT_FALSE(loaded.load(path));
+    EXPECT_EQ(loaded.size_mb(), 1);
+    EXPECT_FALSE(loaded.load(path + ".missing"));
+
+    std::filesystem::remove(path);
+}
+
+TEST(TranspositionTableTest, stats)
+{
+    tt::TTable ttable(1);
+    tt::TTable::Stats stats;
+    bool found = false;
+
+    ttable.probe(cluster_key(1), found, &stats);
+    for (uint64_t i = 0; i < tt::TTable::CLUSTER_SIZE; ++i)
+        ttable.insert(cluster_key(i + 1), tt::TTEntry(0, 10, tt::Flag::kUPPER_BOUND, NO_MOVE), &stats);
+    ttable.probe(cluster_key(1), found, &stats);
+    ttable.probe(cluster_key(10), found, &stats);
+    ttable.insert(cluster_key(10), tt::TTEntry(0, 5, tt::Flag::kUPPER_BOUND, NO_MOVE), &stats);
+    ttable.insert(cluster_key(10), tt::TTEntry(0, 1, tt::Flag::kUPPER_BOUND, NO_MOVE), &stats);
+
+    EXPECT_EQ(stats.probes, 3);
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.collisions, 1);
+    EXPECT_EQ(stats.stores, 4);
+    EXPECT_EQ(stats.replaced, 1);
+    EXPECT_EQ(stats.overwrote_deeper, 1);
+    EXPECT_EQ(stats.kept_deeper, 1);
+
+    ttable.add_stats(stats);
+    ttable.add_stats(stats);
+    EXPECT_EQ(ttable.stats().probes, 6);
+
+    const tt::TTable::Usage usage = ttable.usage();
+    EXPECT_EQ(usage.entries, 1024 * 1024 / sizeof(tt::TTable::Cluster) * tt::TTable::CLUSTER_SIZE);
+    EXPECT_EQ(usage.used, tt::TTable::CLUSTER_SIZE);
+    EXPECT_EQ(usage.current, tt::TTable::CLUSTER_SIZE);
+
+    ttable.clear();
+    EXPECT_EQ(ttable.stats().probes, 0);
+    EXPECT_EQ(ttable.usage().used, 0);
+}
+
+}  // namespace
@@ -49,32 +49,6 @@ TEST(TypesTest, create_castling)
     }
 }
 
-TEST(TypesTest, create_moveinfo)
-{
-    for (uint32_t piecekind = NO_PIECE_KIND; piecekind <= QUEEN; ++piecekind)
-    {
-        for (uint32_t castling = NO_CASTLING; castling <= ALL_CASTLING; ++castling)
-        {
-            for (Square square = SQ_A1; square <= NO_SQUARE; ++square)
-            {
-                for (bool b : {false, true})
-                {
-                    for (uint8_t half_move = 0; half_move < 100; ++half_move)
-                    {
-                        MoveInfo moveinfo = create_moveinfo(PieceKind(piecekind), Castling(castling),
-                                                            square, b, half_move);
-                        EXPECT_EQ(captured_piece(moveinfo), PieceKind(piecekind));
-                        EXPECT_EQ(last_castling(moveinfo), Castling(castling));
-                        EXPECT_EQ(last_enpassant_square(moveinfo), square);
-                        EXPECT_EQ(enpassant(moveinfo), b);
-                        EXPECT_EQ(half_move_counter(moveinfo), half_move);
-                    }
-                }
-            }
-        }
-    }
-}
-
 TEST(TypesTest, square)
 {
     for (Rank r = RANK_1; r <= RANK_8; ++r)
@@ -94,6 +68,28 @@ TEST(TypesTest, square)
     }
 }
 
+TEST(TypesTest, pack_move)
+{
+    EXPECT_EQ(unpack_move(pack_move(NO_MOVE)), NO_MOVE);
+    EXPECT_EQ(unpack_move(pack_move(KING_CASTLING_MOVE)), KING_CASTLING_MOVE);
+    EXPECT_EQ(unpack_move(pack_move(QUEEN_CASTLING_MOVE)), QUEEN_CASTLING_MOVE);
+
+    for (Square from_sq = SQ_A1; from_sq <= SQ_H8; ++from_sq)
+    {
+        for (Square to_sq = SQ_A1; to_sq <= SQ_H8; ++to_sq)
+        {
+            Move move = create_move(from_sq, to_sq);
+            EXPECT_EQ(unpack_move(pack_move(move)), move);
+
+            for (PieceKind piecekind = KNIGHT; piecekind <= QUEEN; ++piecekind)
+            {
+                move = create_promotion(from_sq, to_sq, piecekind);
+                EXPECT_EQ(unpack_move(pack_move(move)), move);
+            }
+        }
+    }
+}
+
 TEST(TypesTest, PieceCountVector)
 {
     PieceCountVector pcv = create_pcv(1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
@@ -0,0 +1,40 @@
+#include "endgame.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace engine;
+
+/*
+ * Writes KPK bitbase as a comma separated list of words,
+ * it's included by engine/bitbase.cpp.
+ */
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <output file>" << std::endl;
+        return 1;
+    }
+
+    std::ofstream stream(argv[1]);
+    if (!stream)
+    {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    const std::vector<uint32_t> bitbase = bitbase::generate();
+
+    stream << "// Generated by bitbase_generator, do not edit.\n";
+    char word[16];
+    for (size_t i = 0; i < bitbase.size(); ++i)
+    {
+        std::snprintf(word, sizeof(word), "0x%08x,", bitbase[i]);
+        stream << word << ((i % 8 == 7) ? "\n" : " ");
+    }
+
+    return stream ? 0 : 1;
+}
@@ -6,6 +6,7 @@
 #include "extended_position.h"
 #include "movegen.h"
 #include "polyglot.h"
+#include "psqt.h"
 #include "timer.h"
 #include "uci.h"
 #include "zobrist_hash.h"
@@ -159,8 +160,8 @@ int main(int argc, char** argv)
     std::ofstream fd(args.pgn_file);
 
     move_bitboards::init();
+    psqt::init();
     zobrist::init();
-    bitbase::init();
     endgame::init();
     eco::init();
 